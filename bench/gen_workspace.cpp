@@ -0,0 +1,105 @@
+// Synthetic tier-folder workspace generator for the workload benchmark.
+//
+// Usage: bjmgr-bench-gen <dir> [--files N] [--misplaced F] [--missing F] [--seed S]
+//
+// Creates N empty solutions under <dir>/<Tier>/<Tier L>/<id>.cpp with a
+// level distribution centred on silver/gold. A fraction F of them is put
+// in a wrong tier folder (work for `patch`) and a further fraction of
+// solved problems is left out of the tree (work for `update`).
+//
+// The ground truth is written to <dir>/.bench-levels.tsv as
+// "<id>\t<level>\t<present>" lines for the replay server to serve.
+
+#include <string>
+#include <vector>
+#include <random>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "tier.h"
+
+namespace fs = std::filesystem;
+
+static void usage() {
+    std::fprintf(stderr, "Usage: bjmgr-bench-gen <dir> [--files N] [--misplaced F] [--missing F] [--seed S]\n");
+    std::exit(1);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) usage();
+
+    fs::path dir = argv[1];
+    i32 files = 10000;
+    f64 misplaced = 0.05, missing = 0.02;
+    u32 seed = 1;
+
+    for (i32 i = 2; i < argc; i++) {
+        if (i + 1 >= argc) usage();
+
+        if (!std::strcmp(argv[i], "--files")) files = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--misplaced")) misplaced = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--missing")) missing = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--seed")) seed = std::atoi(argv[++i]);
+        else usage();
+    }
+
+    if (fs::exists(dir) && !fs::is_empty(dir)) {
+        std::fprintf(stderr, "'%s': Directory is not empty\n", dir.c_str());
+        return 1;
+    }
+
+    std::mt19937 rng(seed);
+
+    // Roughly what an active solver's archive looks like: most problems
+    // between silver and gold, a long tail towards ruby.
+    std::vector<f64> w(31, 0);
+    for (i32 l = 1; l <= 30; l++) w[l] = std::exp(-std::pow(l - 10.5, 2) / (2 * 5.5 * 5.5));
+    std::discrete_distribution<i32> level_dist(w.begin(), w.end());
+    std::uniform_real_distribution<f64> unit(0, 1);
+    std::uniform_int_distribution<i32> any_level(1, 30);
+
+    i32 solved = files + (i32)(files * missing);
+
+    // Distinct problem ids from the BOJ range.
+    std::vector<i32> ids(std::max(solved * 3, 30000));
+    for (i32 i = 0; i < (i32)ids.size(); i++) ids[i] = 1000 + i;
+    std::shuffle(ids.begin(), ids.end(), rng);
+    ids.resize(solved);
+
+    fs::create_directories(dir);
+    std::ofstream truth(dir / ".bench-levels.tsv");
+
+    i32 moved = 0;
+
+    for (i32 i = 0; i < solved; i++) {
+        i32 id = ids[i], lv = level_dist(rng);
+        bool present = i < files;
+
+        truth << id << "\t" << lv << "\t" << (i32)present << "\n";
+
+        if (!present) continue;
+
+        i32 at = lv;
+        if (unit(rng) < misplaced) {
+            while ((at = any_level(rng)) == lv);
+            moved++;
+        }
+
+        fs::path p = dir / tier_t(at).path();
+        fs::create_directories(p);
+        std::ofstream(p / (std::to_string(id) + ".cpp")).close();
+    }
+
+    std::printf(
+        "{\"files\":%d,\"misplaced\":%d,\"missing\":%d,\"seed\":%u}\n",
+        files, moved, solved - files, seed
+    );
+
+    return 0;
+}
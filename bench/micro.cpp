@@ -0,0 +1,212 @@
+// Microbenchmarks for the hot utility paths.
+//
+// Each case is run with a doubling iteration count until one batch takes
+// at least 100ms, then reported as the best of five batches in ns/op.
+// Heap allocations are counted through the global operator new.
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <algorithm>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "arg.h"
+#include "tier.h"
+#include "strlib.h"
+#include "catalog.h"
+
+#include <unistd.h>
+
+static std::atomic<u64> _allocs { 0 };
+
+void* operator new(std::size_t n) {
+    _allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+template <typename T>
+inline void keep(T&& v) { asm volatile("" : : "g"(&v) : "memory"); }
+
+static const char* _filter = nullptr;
+
+template <typename F>
+void bench(const char* name, F f) {
+    if (_filter && !std::strstr(name, _filter)) return;
+
+    using clock = std::chrono::steady_clock;
+
+    auto batch = [&] (u64 n) {
+        auto s = clock::now();
+        for (u64 i = 0; i < n; i++) f();
+        return std::chrono::duration<f64, std::nano>(clock::now() - s).count();
+    };
+
+    u64 n = 1;
+    while (batch(n) < 1e8 && n < (1ull << 40)) n *= 2;
+
+    f64 best = 1e300;
+    u64 a0 = _allocs.load();
+    for (i32 r = 0; r < 5; r++) best = std::min(best, batch(n));
+    f64 allocs = (f64)(_allocs.load() - a0) / (5 * n);
+
+    std::printf("%-32s %12.2f ns/op %10.2f allocs/op\n", name, best / n, allocs);
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) _filter = argv[1];
+
+    std::printf("%-32s %18s %20s\n", "benchmark", "time", "allocations");
+
+    // tier_t
+    {
+        std::string g3 = "G3";
+        i32 lv = 11;
+
+        bench("tier_t(string)", [&] { tier_t t(g3); keep(t); });
+        bench("tier_t(i32)", [&] { tier_t t(lv); keep(t); });
+
+        tier_t t(g3);
+        bench("tier_t::operator i32", [&] { i32 v = (i32)t; keep(v); });
+        bench("tier_t::long_name", [&] { auto s = t.long_name(); keep(s); });
+        bench("tier_t::path", [&] { auto s = t.path(); keep(s); });
+    }
+
+    // tier_range
+    {
+        std::string r1 = "b3..s1", r2 = "d", r3 = "..p2", r4 = "b..s1,g3,!s2";
+
+        bench("tier_range(\"b3..s1\")", [&] { tier_range r(r1); keep(r); });
+        bench("tier_range(\"d\")", [&] { tier_range r(r2); keep(r); });
+        bench("tier_range(\"..p2\")", [&] { tier_range r(r3); keep(r); });
+        bench("tier_range(\"b..s1,g3,!s2\")", [&] { tier_range r(r4); keep(r); });
+
+        tier_range r(r1);
+        i32 i = 0;
+        bench("tier_range::contains", [&] {
+            bool b = r.contains(tier_t(i = i % 30 + 1)); keep(b);
+        });
+    }
+
+    // strlib
+    {
+        std::vector<std::string> ids;
+        for (i32 i = 1000; i < 1100; i++) ids.push_back(std::to_string(i));
+
+        std::string csv = strlib::join(ids.begin(), ids.end(), ",");
+        std::string padded = "   \t  Gold 3 \n  ";
+
+        bench("strlib::split (100 tokens)", [&] {
+            auto v = strlib::split<std::vector<std::string>>(csv, ','); keep(v);
+        });
+        bench("strlib::split views (100 tokens)", [&] {
+            auto v = strlib::split<std::vector<std::string_view>>(csv, ','); keep(v);
+        });
+        bench("strlib::split_views (100 tokens)", [&] {
+            size_t n = 0; strlib::split_views(csv, ',', [&] (std::string_view s) { n += s.size(); }); keep(n);
+        });
+        bench("strlib::join (100 tokens)", [&] {
+            auto s = strlib::join(ids.begin(), ids.end(), ","); keep(s);
+        });
+        std::vector<i32> nums;
+        for (i32 i = 1000; i < 1100; i++) nums.push_back(i);
+
+        std::string url;
+        bench("strlib::append_join (100 ids)", [&] {
+            url.assign("https://solved.ac/api/v3/problem/lookup?problemIds=");
+            strlib::append_join(url, nums.begin(), nums.end(), ","); keep(url);
+        });
+        bench("strlib::trim", [&] { auto s = strlib::trim(padded); keep(s); });
+
+        // A 64 KiB source file of 40-byte lines, against the byte loop.
+        std::string src;
+        while (src.size() < 65536) src += "    for (int i = 0; i < n; i++) a[i]++;\n";
+
+        bench("strlib::count (64 KiB)", [&] { auto n = strlib::count(src, '\n'); keep(n); });
+        bench("std::count (64 KiB)", [&] { auto n = std::count(src.begin(), src.end(), '\n'); keep(n); });
+    }
+
+    // parse_command
+    {
+        static constexpr auto opts = make_options({
+            { "log", true, 'l' },
+            { "dir", true, 'd' },
+            { "filter", true, 'f' },
+            { "extension", true, 'x' },
+            { "yes", false, 'y' },
+            { "code", false, 'c' }
+        });
+
+        const char* argvs[] {
+            "solvedac", "--log", "./log.txt", "-d../", "--filter", "s..d3", "-yc"
+        };
+
+        bench("parse_command (7 tokens)", [&] {
+            args a; auto r = parse_command(7, argvs, opts, a); keep(r); keep(a);
+        });
+    }
+
+    // catalog_t, over 30k synthetic titles of Hangul words from a small
+    // syllable pool, so trigrams repeat the way real titles do.
+    if (!_filter || std::strstr("catalog_t::search", _filter)) {
+        u32 seed = 12345;
+        auto rnd = [&] (u32 n) { seed = seed * 1103515245 + 12345; return (seed >> 8) % n; };
+
+        auto syllable = [&] {
+            char32_t c = 0xAC00 + rnd(160) * 7;
+            std::string s;
+            s += (char)(0xE0 | c >> 12);
+            s += (char)(0x80 | (c >> 6 & 0x3F));
+            s += (char)(0x80 | (c & 0x3F));
+            return s;
+        };
+
+        std::vector<problem_t> ps;
+
+        for (i32 i = 0; i < 30000; i++) {
+            problem_t p;
+            p.id = 1000 + i;
+            p.tier = tier_t((i32)rnd(31));
+
+            for (u32 w = 0, nw = 1 + rnd(4); w < nw; w++) {
+                if (w) p.name += ' ';
+                if (rnd(8) == 0) { p.name += "Tree"; continue; }
+                for (u32 k = 0, nk = 2 + rnd(3); k < nk; k++) p.name += syllable();
+            }
+
+            ps.push_back(std::move(p));
+        }
+
+        std::string path = "/tmp/bjmgr-micro-catalog-" + std::to_string(getpid());
+        catalog_t::merge(path, ps);
+
+        {
+            catalog_t cat(path);
+
+            // The start of a title whose first word is at least three
+            // syllables (nine bytes) long; two syllables are below trigram
+            // length and take the scan.
+            auto it = std::find_if(ps.begin() + 12345, ps.end(), [] (const problem_t& p) {
+                return p.name.size() >= 9 && p.name.find_first_of(" T") >= 9;
+            });
+            std::string q3 = it->name.substr(0, 9), q2 = it->name.substr(0, 6);
+
+            bench("catalog_t(open)", [&] { catalog_t c(path); keep(c); });
+            bench("catalog_t::search (3 chars)", [&] { auto r = cat.search(q3); keep(r); });
+            bench("catalog_t::search (2 chars)", [&] { auto r = cat.search(q2); keep(r); });
+            bench("catalog_t::search (\"tree\")", [&] { auto r = cat.search("tree"); keep(r); });
+        }
+
+        std::remove(path.c_str());
+    }
+
+    return 0;
+}
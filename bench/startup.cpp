@@ -0,0 +1,185 @@
+// Startup-time benchmark for the commands that never touch the network.
+//
+// Usage: bjmgr-bench-startup --bjmgr <path> --workspace <dir> [--runs N] [--daemon] [--out <file>]
+//
+// Runs `help`, `info` with and without the workspace index and an offline
+// `new -t D3` N times each (default 50) and prints the wall time of every
+// case as JSON. /bin/true is measured alongside as the process spawn floor.
+// With --daemon, a private `bjmgr daemon` is started and `info` is also
+// timed through it, both as a spawned client and as a bare socket round
+// trip from this process.
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <unistd.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+
+#include "intdef.h"
+#include "service.h"
+
+namespace fs = std::filesystem;
+
+static f64 run(const std::vector<std::string>& cmd, const std::vector<std::string>& env, i32& status) {
+    auto s = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+
+    if (pid == 0) {
+        int null = open("/dev/null", O_RDWR);
+        dup2(null, 0); dup2(null, 1); dup2(null, 2);
+
+        for (auto& e : env) putenv((char*)e.c_str());
+
+        std::vector<char*> av;
+        for (auto& a : cmd) av.push_back((char*)a.c_str());
+        av.push_back(nullptr);
+
+        execv(av[0], av.data());
+        _exit(127);
+    }
+
+    int st;
+    waitpid(pid, &st, 0);
+    // 128 + signal, as in bjmgr-bench-workload, so a crash outranks exit 0.
+    status = WIFEXITED(st) ? WEXITSTATUS(st) : 128 + WTERMSIG(st);
+
+    return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - s).count();
+}
+
+static void usage() {
+    std::fprintf(stderr, "Usage: bjmgr-bench-startup --bjmgr <path> --workspace <dir> [--runs N] [--daemon] [--out <file>]\n");
+    std::exit(1);
+}
+
+int main(int argc, char** argv) {
+    std::string bin, ws, out_path;
+    i32 runs = 50;
+    bool daemon = false;
+
+    for (i32 i = 1; i < argc; i++) {
+        std::string a = argv[i];
+
+        if (a == "--daemon") { daemon = true; continue; }
+        if (i + 1 >= argc) usage();
+
+        if (a == "--bjmgr") bin = fs::absolute(argv[++i]);
+        else if (a == "--workspace") ws = fs::absolute(argv[++i]);
+        else if (a == "--runs") runs = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--out") out_path = argv[++i];
+        else usage();
+    }
+
+    if (bin.empty() || ws.empty()) usage();
+
+    fs::path tmp = fs::temp_directory_path() / ("bjmgr-startup-" + std::to_string(getpid()));
+    fs::create_directories(tmp);
+
+    // Build the index once so the "indexed" case starts warm.
+    i32 st;
+    run({ bin, "info", "-d", ws }, { "BJMGR_NO_DAEMON=1" }, st);
+
+    struct case_t { std::string name; std::vector<std::string> cmd, env; };
+    std::vector<case_t> cases {
+        { "true", { "/bin/true" }, { } },
+        { "help", { bin, "help" }, { } },
+        { "info_scan", { bin, "info", "-d", ws }, { "BJMGR_NO_INDEX=1", "BJMGR_NO_DAEMON=1" } },
+        { "info_indexed", { bin, "info", "-d", ws }, { "BJMGR_NO_DAEMON=1" } },
+        { "new_offline", { bin, "new", "1000", "-t", "D3", "-y", "-d", tmp.string() }, { "BJMGR_NO_DAEMON=1" } }
+    };
+
+    pid_t dpid = -1;
+    std::string sock = (tmp / "bjmgr.sock").string();
+
+    if (daemon) {
+        setenv("BJMGR_SOCKET", sock.c_str(), 1);
+
+        if ((dpid = fork()) == 0) {
+            int null = open("/dev/null", O_RDWR);
+            dup2(null, 0); dup2(null, 1); dup2(null, 2);
+            execl(bin.c_str(), bin.c_str(), "daemon", (char*)nullptr);
+            _exit(127);
+        }
+
+        struct stat sb;
+        for (i32 i = 0; i < 500 && stat(sock.c_str(), &sb); i++) usleep(10000);
+
+        cases.push_back({ "info_daemon", { bin, "info", "-d", ws }, { } });
+    }
+
+    std::string json = "{\"runs\":" + std::to_string(runs) + ",\"results\":[";
+
+    for (size_t c = 0; c < cases.size(); c++) {
+        auto& k = cases[c];
+        std::vector<f64> wall;
+        i32 status = 0;
+
+        for (i32 r = 0; r < runs; r++) {
+            wall.push_back(run(k.cmd, k.env, st));
+            status = std::max(status, st);
+        }
+
+        std::sort(wall.begin(), wall.end());
+
+        char line[256];
+        std::snprintf(line, sizeof(line),
+            "%s{\"command\":\"%s\",\"exit_status\":%d,"
+            "\"wall_ms\":{\"min\":%.3f,\"median\":%.3f,\"max\":%.3f}}",
+            c ? "," : "", k.name.c_str(), status,
+            wall.front(), wall[wall.size() / 2], wall.back()
+        );
+        json += line;
+    }
+
+    if (daemon) {
+        // The request as the client sends it, minus process startup.
+        std::string a1 = "info", a2 = "-d";
+        char* av[] { bin.data(), a1.data(), a2.data(), ws.data() };
+
+        int null = open("/dev/null", O_RDWR), o1 = dup(1), o2 = dup(2);
+        std::vector<f64> wall;
+        i32 status = 0;
+
+        dup2(null, 1); dup2(null, 2);
+
+        for (i32 r = 0; r < runs; r++) {
+            auto s = std::chrono::steady_clock::now();
+            if (!service::forward(4, av, st)) st = -1;
+            wall.push_back(std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - s).count());
+            status = std::max(status, st);
+        }
+
+        dup2(o1, 1); dup2(o2, 2);
+        close(null); close(o1); close(o2);
+
+        std::sort(wall.begin(), wall.end());
+
+        char line[256];
+        std::snprintf(line, sizeof(line),
+            ",{\"command\":\"info_daemon_rtt\",\"exit_status\":%d,"
+            "\"wall_ms\":{\"min\":%.3f,\"median\":%.3f,\"max\":%.3f}}",
+            status, wall.front(), wall[wall.size() / 2], wall.back()
+        );
+        json += line;
+
+        kill(dpid, SIGTERM);
+        waitpid(dpid, &st, 0);
+    }
+
+    json += "]}\n";
+    fs::remove_all(tmp);
+
+    if (out_path.empty()) std::fputs(json.c_str(), stdout);
+    else std::ofstream(out_path) << json;
+
+    return 0;
+}
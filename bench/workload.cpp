@@ -0,0 +1,401 @@
+// End-to-end workload benchmark.
+//
+// Usage: bjmgr-bench-workload --bjmgr <path> --workspace <dir>
+//                             [--runs N] [--syscalls] [--out <file>]
+//
+// Serves the workspace's .bench-levels.tsv (see gen_workspace.cpp) as a
+// local replay of the solved.ac endpoints bjmgr uses, points bjmgr at it
+// through BJMGR_API_URL and runs `info`, `patch` and `update` against
+// fresh copies of the workspace. Wall time, CPU time and peak RSS come
+// from wait4(); with --syscalls one extra ptrace'd run per command counts
+// system calls. Results are printed as JSON.
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <algorithm>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/ptrace.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "intdef.h"
+
+namespace fs = std::filesystem;
+
+struct entry_t { i32 id, level; bool present; };
+
+static std::vector<entry_t> _solved;
+static std::unordered_map<i32, i32> _levels;
+
+/* Replay server */
+
+static void problem_json(std::string& out, i32 id, i32 lv) {
+    static const char* tags[] = {
+        "implementation", "math", "dp", "graphs", "greedy", "string", "bruteforcing", "data_structures"
+    };
+
+    out += "{\"problemId\":" + std::to_string(id) +
+        ",\"titleKo\":\"Problem " + std::to_string(id) +
+        "\",\"level\":" + std::to_string(lv);
+
+    // Solver count and one to three tags, fixed per id.
+    u32 h = (u32)id * 2654435761u;
+
+    out += ",\"acceptedUserCount\":" + std::to_string(h >> 17) + ",\"tags\":[";
+
+    for (u32 k = 0, n = 1 + h % 3; k < n; k++) {
+        if (k) out += ',';
+        out += "{\"key\":\"";
+        out += tags[(h >> (8 + 3 * k)) % 8];
+        out += "\",\"isMeta\":false}";
+    }
+
+    out += "]}";
+}
+
+static std::string query_param(const std::string& target, const std::string& key) {
+    auto q = target.find('?');
+    if (q == std::string::npos) return "";
+
+    std::string s = "&" + target.substr(q + 1);
+    auto p = s.find("&" + key + "=");
+    if (p == std::string::npos) return "";
+
+    p += key.size() + 2;
+    return s.substr(p, s.find('&', p) - p);
+}
+
+static std::string route(const std::string& target, i32& status) {
+    std::string body;
+    status = 200;
+
+    if (target.find("/problem/lookup") != std::string::npos) {
+        std::string ids = query_param(target, "problemIds");
+        std::stringstream ss(ids);
+        bool first = true;
+
+        body = "[";
+        for (std::string s; std::getline(ss, s, ',');) {
+            i32 id = std::atoi(s.c_str());
+            auto it = _levels.find(id);
+            if (it == _levels.end()) continue;
+
+            if (!first) body += ",";
+            problem_json(body, id, it->second);
+            first = false;
+        }
+        body += "]";
+    } else if (target.find("/problem/show") != std::string::npos) {
+        i32 id = std::atoi(query_param(target, "problemId").c_str());
+        auto it = _levels.find(id);
+
+        if (it == _levels.end()) { status = 404; return "Not Found"; }
+        problem_json(body, id, it->second);
+    } else if (target.find("/search/problem") != std::string::npos) {
+        std::string pg = query_param(target, "page");
+        i32 page = pg.empty() ? 1 : std::atoi(pg.c_str());
+        i32 b = (page - 1) * 50, e = std::min<i32>(b + 50, _solved.size());
+
+        body = "{\"count\":" + std::to_string(_solved.size()) + ",\"items\":[";
+        for (i32 i = b; i < e; i++) {
+            if (i != b) body += ",";
+            problem_json(body, _solved[i].id, _solved[i].level);
+        }
+        body += "]}";
+    } else {
+        status = 404;
+        body = "Not Found";
+    }
+
+    return body;
+}
+
+static void serve(int fd) {
+    std::string in;
+    char buf[1 << 14];
+
+    for (;;) {
+        auto end = in.find("\r\n\r\n");
+
+        if (end == std::string::npos) {
+            ssize_t r = ::read(fd, buf, sizeof(buf));
+            if (r <= 0) break;
+            in.append(buf, r);
+            continue;
+        }
+
+        std::string head = in.substr(0, end);
+        in.erase(0, end + 4);
+
+        auto sp1 = head.find(' '), sp2 = head.find(' ', sp1 + 1);
+        std::string target = head.substr(sp1 + 1, sp2 - sp1 - 1);
+
+        i32 status;
+        std::string body = route(target, status);
+        std::string res =
+            "HTTP/1.1 " + std::to_string(status) + (status == 200 ? " OK" : " Not Found") + "\r\n"
+            "Content-Type: application/json\r\n"
+            "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+
+        for (size_t off = 0; off < res.size();) {
+            ssize_t r = ::write(fd, res.data() + off, res.size() - off);
+            if (r <= 0) { ::close(fd); return; }
+            off += r;
+        }
+    }
+
+    ::close(fd);
+}
+
+static i32 start_server() {
+    int ls = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(ls, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+
+    if (bind(ls, (sockaddr*)&addr, sizeof(addr)) || listen(ls, 64)) {
+        std::perror("replay server");
+        std::exit(1);
+    }
+
+    socklen_t len = sizeof(addr);
+    getsockname(ls, (sockaddr*)&addr, &len);
+
+    std::thread([ls] {
+        for (;;) {
+            int fd = accept(ls, nullptr, nullptr);
+            if (fd < 0) { if (errno == EINTR) continue; return; }
+            std::thread(serve, fd).detach();
+        }
+    }).detach();
+
+    return ntohs(addr.sin_port);
+}
+
+/* Process measurement */
+
+struct run_t {
+    f64 wall_ms, user_ms, sys_ms;
+    i64 max_rss_kb;
+    i32 status;
+};
+
+static void child_exec(const std::vector<std::string>& cmd, const std::string& input, bool traced) {
+    int in = input.empty() ? open("/dev/null", O_RDONLY) : open(input.c_str(), O_RDONLY);
+    int out = open("/dev/null", O_WRONLY);
+    dup2(in, 0); dup2(out, 1); dup2(out, 2);
+
+    if (traced) {
+        ptrace(PTRACE_TRACEME, 0, nullptr, nullptr);
+        raise(SIGSTOP);
+    }
+
+    std::vector<char*> av;
+    for (auto& s : cmd) av.push_back((char*)s.c_str());
+    av.push_back(nullptr);
+
+    execv(av[0], av.data());
+    _exit(127);
+}
+
+static run_t measure(const std::vector<std::string>& cmd, const std::string& input) {
+    auto s = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+
+    if (pid == 0) child_exec(cmd, input, false);
+
+    int st; rusage ru;
+    wait4(pid, &st, 0, &ru);
+
+    run_t r;
+    r.wall_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - s).count();
+    r.user_ms = ru.ru_utime.tv_sec * 1e3 + ru.ru_utime.tv_usec / 1e3;
+    r.sys_ms = ru.ru_stime.tv_sec * 1e3 + ru.ru_stime.tv_usec / 1e3;
+    r.max_rss_kb = ru.ru_maxrss;
+    // As a shell reports it, so a crash is never lower than a clean exit.
+    r.status = WIFEXITED(st) ? WEXITSTATUS(st) : 128 + WTERMSIG(st);
+
+    return r;
+}
+
+// Counts syscall entries over every thread of the child.
+static i64 count_syscalls(const std::vector<std::string>& cmd, const std::string& input) {
+    pid_t pid = fork();
+
+    if (pid == 0) child_exec(cmd, input, true);
+
+    int st;
+    waitpid(pid, &st, 0);
+    ptrace(
+        PTRACE_SETOPTIONS, pid, nullptr,
+        PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACECLONE | PTRACE_O_TRACEFORK | PTRACE_O_TRACEVFORK | PTRACE_O_EXITKILL
+    );
+    ptrace(PTRACE_SYSCALL, pid, nullptr, nullptr);
+
+    std::unordered_map<pid_t, bool> in_call;
+    i64 count = 0;
+
+    for (;;) {
+        pid_t w = waitpid(-1, &st, __WALL);
+        if (w < 0) break;
+        if (!WIFSTOPPED(st)) continue;
+
+        int sig = WSTOPSIG(st);
+
+        if (sig == (SIGTRAP | 0x80)) {
+            if (!in_call[w]) count++;
+            in_call[w] = !in_call[w];
+            sig = 0;
+        } else if (sig == SIGTRAP || sig == SIGSTOP)
+            sig = 0;
+
+        ptrace(PTRACE_SYSCALL, w, nullptr, (void*)(intptr_t)sig);
+    }
+
+    return count;
+}
+
+/* Driver */
+
+static void usage() {
+    std::fprintf(stderr,
+        "Usage: bjmgr-bench-workload --bjmgr <path> --workspace <dir>"
+        " [--runs N] [--syscalls] [--out <file>]\n");
+    std::exit(1);
+}
+
+int main(int argc, char** argv) {
+    std::string bin, ws, out_path;
+    i32 runs = 3;
+    bool syscalls = false;
+
+    for (i32 i = 1; i < argc; i++) {
+        std::string a = argv[i];
+
+        if (a == "--syscalls") { syscalls = true; continue; }
+        if (i + 1 >= argc) usage();
+
+        if (a == "--bjmgr") bin = fs::absolute(argv[++i]);
+        else if (a == "--workspace") ws = fs::absolute(argv[++i]);
+        else if (a == "--runs") runs = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--out") out_path = argv[++i];
+        else usage();
+    }
+
+    if (bin.empty() || ws.empty()) usage();
+
+    std::ifstream truth(fs::path(ws) / ".bench-levels.tsv");
+    if (!truth) {
+        std::fprintf(stderr, "'%s': No .bench-levels.tsv (create it with bjmgr-bench-gen)\n", ws.c_str());
+        return 1;
+    }
+
+    i32 files = 0, missing = 0;
+    for (entry_t e; truth >> e.id >> e.level >> e.present;) {
+        _solved.push_back(e);
+        _levels[e.id] = e.level;
+        (e.present ? files : missing)++;
+    }
+
+    i32 port = start_server();
+    setenv("BJMGR_API_URL", ("http://127.0.0.1:" + std::to_string(port) + "/").c_str(), 1);
+    // A running daemon would answer info with its own environment.
+    setenv("BJMGR_NO_DAEMON", "1", 1);
+
+    fs::path tmp = fs::temp_directory_path() / ("bjmgr-workload-" + std::to_string(getpid()));
+    fs::create_directories(tmp);
+
+    // Keep the replayed titles out of the user's search catalog.
+    setenv("BJMGR_CATALOG", (tmp / "catalog").c_str(), 1);
+
+    // update asks next/skip/quit for every created file.
+    std::string answers = (tmp / "answers").string();
+    std::ofstream(answers) << std::string(missing + 16, 'n');
+
+    struct case_t { std::string name; bool copy; std::vector<std::string> args; std::string input; };
+    std::vector<case_t> cases {
+        { "info", false, { "info", "-d", ws }, "" },
+        { "patch", true, { "patch", "-y", "-l", (tmp / "log").string() }, "" },
+        { "update", true, { "update", "bench", "-y", "-l", (tmp / "log").string() }, answers }
+    };
+
+    std::string json = "{\"workspace\":{\"files\":" + std::to_string(files) +
+        ",\"missing\":" + std::to_string(missing) + "},\"results\":[";
+
+    for (size_t c = 0; c < cases.size(); c++) {
+        auto& k = cases[c];
+        std::vector<run_t> rs;
+        i64 sc = -1;
+
+        auto prepare = [&] {
+            std::vector<std::string> cmd { bin };
+            cmd.insert(cmd.end(), k.args.begin(), k.args.end());
+
+            if (k.copy) {
+                fs::path w = tmp / "ws";
+                fs::remove_all(w);
+                fs::copy(ws, w, fs::copy_options::recursive);
+                cmd.push_back("-d"); cmd.push_back(w.string());
+            }
+
+            return cmd;
+        };
+
+        for (i32 r = 0; r < runs; r++) rs.push_back(measure(prepare(), k.input));
+        if (syscalls) sc = count_syscalls(prepare(), k.input);
+
+        std::vector<f64> wall;
+        for (auto& r : rs) wall.push_back(r.wall_ms);
+        std::sort(wall.begin(), wall.end());
+
+        auto med = [] (std::vector<f64> v) { std::sort(v.begin(), v.end()); return v[v.size() / 2]; };
+        std::vector<f64> user, sys;
+        i64 rss = 0;
+        i32 status = 0;
+        for (auto& r : rs) {
+            user.push_back(r.user_ms); sys.push_back(r.sys_ms);
+            rss = std::max(rss, r.max_rss_kb);
+            status = std::max(status, r.status);
+        }
+
+        char line[512];
+        std::snprintf(line, sizeof(line),
+            "%s{\"command\":\"%s\",\"runs\":%d,\"exit_status\":%d,"
+            "\"wall_ms\":{\"min\":%.3f,\"median\":%.3f,\"max\":%.3f},"
+            "\"user_ms\":%.3f,\"sys_ms\":%.3f,\"max_rss_kb\":%lld,\"syscalls\":%lld}",
+            c ? "," : "", k.name.c_str(), runs, status,
+            wall.front(), med(wall), wall.back(),
+            med(user), med(sys), (long long)rss, (long long)sc
+        );
+        json += line;
+    }
+
+    json += "]}\n";
+    fs::remove_all(tmp);
+
+    if (out_path.empty()) std::fputs(json.c_str(), stdout);
+    else std::ofstream(out_path) << json;
+
+    return 0;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#ifdef ANSI_ENABLED
+#define USE_COLOR(x) "\033[" #x "m"
+#else
+#define USE_COLOR(x) ""
+#endif
+#define RESET USE_COLOR(0)
+#define COLOR(x) USE_COLOR(38;5;x)
+#define COLORED_TEXT(x, s) COLOR(x) s RESET
+#define COLORED_APP_NAME COLOR(214) APP_NAME COLOR(0) RESET
+#define COLORED_USAGE COLOR(112) "Usage" RESET
+#define COLORED_MENU(s) COLOR(218) s RESET
+#define COLORED_ERROR COLOR(160) "Error" RESET
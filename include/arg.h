@@ -2,39 +2,145 @@
 
 #include <vector>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <optional>
+#include <stdexcept>
+#include <array>
 #include <utility>
 
 #include "intdef.h"
-#include "strlib.h"
+
+// Result of parse_command.
+enum class parse_error_t : u8 {
+    none, option_name, dquote, unknown_option, parameter_missing, stdin_arg
+};
+
+// Error of an opt_table_t.
+enum class table_error_t : u8 {
+    none, duplicated_name, duplicated_short_name, invalid_short_name, too_many_options
+};
 
 struct opt_t {
-    opt_t() = default;
+    constexpr opt_t() = default;
     // Create new opt_t object.
     // if option hasn't short name, set __sname to '\0'.
     //
     // short name range : [a-zA-Z]
-    opt_t(const std::string& __name, bool __has_para, char __sname = '\0')
+    constexpr opt_t(std::string_view __name, bool __has_para, char __sname = '\0')
     : name(__name), short_name(__sname), has_parameter(__has_para) { }
 
-    std::string name;
-    char short_name;
-    bool has_parameter;
+    std::string_view name;
+    char short_name = '\0';
+    bool has_parameter = false;
+};
+
+inline constexpr i32 sn2i(char c) {
+    if ('a' <= c && c <= 'z') return c - 'a';
+    if ('A' <= c && c <= 'Z') return c - 'A' + 26;
+    return -1;
+}
+
+// Non-owning view of an opt_table_t handed to parse_command.
+struct opt_view {
+    const opt_t* opts = nullptr;
+    std::size_t size = 0;
+    // Index into opts for every short name, -1 when unused.
+    const i8* short_idx = nullptr;
+    // A lone '-' (stdin) is an argument; elsewhere it is an error.
+    bool stdin_arg = false;
+};
+
+// A command's options with their short name index, built at compile time.
+// error is set when the table is malformed, so a bad table can be
+// rejected with static_assert.
+template <std::size_t N>
+struct opt_table_t {
+    std::array<opt_t, N> opts { };
+    std::array<i8, 52> short_idx { };
+    bool stdin_arg = false;
+    table_error_t error = table_error_t::none;
+
+    constexpr opt_table_t() {
+        for (auto& x : short_idx) x = -1;
+    }
+
+    constexpr opt_table_t(const opt_t (&__opts)[N], bool __stdin_arg = false)
+    : opt_table_t() {
+        stdin_arg = __stdin_arg;
+
+        if (N > 16) { error = table_error_t::too_many_options; return; }
+
+        for (std::size_t i = 0; i < N; i++) {
+            opts[i] = __opts[i];
+
+            for (std::size_t j = 0; j < i; j++)
+                if (opts[j].name == opts[i].name) { error = table_error_t::duplicated_name; return; }
+
+            if (opts[i].short_name == '\0') continue;
+
+            i32 d = sn2i(opts[i].short_name);
+            if (d == -1) { error = table_error_t::invalid_short_name; return; }
+            if (short_idx[d] != -1) { error = table_error_t::duplicated_short_name; return; }
+
+            short_idx[d] = (i8)i;
+        }
+    }
+
+    constexpr operator opt_view() const { return { opts.data(), N, short_idx.data(), stdin_arg }; }
 };
 
+// __stdin_arg for commands that read '-' as stdin.
+template <std::size_t N>
+constexpr opt_table_t<N> make_options(const opt_t (&__opts)[N], bool __stdin_arg = false)
+{ return opt_table_t<N>(__opts, __stdin_arg); }
+
 struct option {
-    std::string name;
-    std::optional<std::string> value;
+    std::string_view name;
+    std::optional<std::string_view> value;
 };
 
-struct args {
-    std::unordered_map<std::string, option> options;
-    std::vector<std::string> args;
+// Options given on one command line. A command has at most 16 options,
+// so a linear scan over a fixed array is cheaper than hashing.
+class option_set {
+public:
+    std::size_t count(std::string_view __name) const { return find(__name) != end(); }
+
+    const option& at(std::string_view __name) const {
+        auto it = find(__name);
+        if (it == end()) throw std::out_of_range("option_set::at");
+        return *it;
+    }
+
+    // Set __name to __value, replacing an earlier occurrence.
+    void set(std::string_view __name, std::optional<std::string_view> __value) {
+        for (auto it = _v.begin(); it != end(); it++)
+            if (it->name == __name) { it->value = __value; return; }
+
+        _v[_n++] = { __name, __value };
+    }
+
+    const option* begin() const { return _v.data(); }
+    const option* end() const { return _v.data() + _n; }
+    bool empty() const { return _n == 0; }
+
+private:
+    const option* find(std::string_view __name) const {
+        auto it = begin();
+        for (; it != end() && it->name != __name; it++);
+        return it;
+    }
+
+    std::array<option, 16> _v;
+    u8 _n = 0;
 };
 
-std::string __err2str(void* f, i32 res);
-i32 init_options(const std::vector<opt_t>& __opts);
-i32 parse_command(const std::vector<std::string>& vs, args& ret);
+// Views point into the argv passed to parse_command and the option
+// table, so both must outlive the args.
+struct args {
+    option_set options;
+    std::vector<std::string_view> args;
+};
 
-#define err2str(f, r) __err2str((void*)(f), (r))
\ No newline at end of file
+const char* parse_errstr(parse_error_t res);
+// Parse argv[0..argc) against opts. Holds no state between calls.
+parse_error_t parse_command(i32 argc, const char* const* argv, const opt_view& opts, args& ret);
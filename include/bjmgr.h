@@ -0,0 +1,188 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <future>
+#include <optional>
+#include <functional>
+#include <filesystem>
+
+#include "intdef.h"
+#include "tier.h"
+#include "problem.h"
+#include "workspace.h"
+
+// libbjmgr: the steps behind the CLI commands, for linking in-process.
+//
+// Nothing here prints, prompts or exits. Workspace and file operations
+// return error values; requests to solved.ac run on a client_t's worker
+// thread and complete through a future or a callback, so a caller can
+// queue several of them and keep going. The bjmgr executable is a thin
+// front end over this header.
+
+// Why a library call failed. Converts to true when it did.
+struct failure_t {
+    enum kind_t : u8 { none, network, http, parse, io };
+
+    kind_t kind = none;
+    // HTTP status for http errors; seconds asked to wait on 429, or 0.
+    long status = 0;
+    i64 retry_after = 0;
+    std::string message;
+    // Response body, when the server sent one.
+    std::string body;
+
+    explicit operator bool() const { return kind != none; }
+};
+
+// A value or the error that prevented it.
+template <typename T>
+class result_t {
+public:
+    result_t(T __value) : _value(std::move(__value)) { }
+    result_t(failure_t __error) : _error(std::move(__error)) { }
+
+    bool ok() const { return _value.has_value(); }
+    const failure_t& error() const { return _error; }
+
+    T& value() { return *_value; }
+    const T& value() const { return *_value; }
+    T* operator->() { return &*_value; }
+    const T* operator->() const { return &*_value; }
+
+private:
+    std::optional<T> _value;
+    failure_t _error;
+};
+
+// Solutions of a workspace: sorted problem ids per level code, and the
+// lang mask (see lang.h) of each, parallel to them.
+struct inventory_t {
+    std::vector<std::vector<i32>> levels = std::vector<std::vector<i32>>(32);
+    std::vector<std::vector<u32>> langs = std::vector<std::vector<u32>>(32);
+
+    // Every solution in a rated folder, ordered by (tier, id).
+    std::vector<record_t> records() const;
+};
+
+// A solution whose folder no longer matches its level on solved.ac.
+struct move_t {
+    i32 id;
+    tier_t from, to;
+    // Files to move, as a lang mask; 0 stands for "<id>.cpp" alone.
+    u32 langs = 0;
+    // Folder the files are in, relative to the root, when it is not the
+    // folder of from.
+    std::string dir;
+};
+
+struct applied_t {
+    enum outcome_t : u8 { moved, skipped, failed };
+
+    move_t move;
+    // skipped: the new level is not a rated tier, so there is no folder.
+    outcome_t outcome;
+    std::string message;
+};
+
+// A solved problem compared against the workspace.
+struct check_t {
+    problem_t problem;
+    bool present;
+    // Missing and inside the filter, i.e. update would create it.
+    bool selected;
+};
+
+class bjmgr {
+public:
+    // Inventory of root, through the workspace index (see workspace.h).
+    static result_t<inventory_t> scan(const std::filesystem::path& root);
+
+    // Files, stubs, lines and bytes of the solutions under root, by level
+    // code and extension. Only files changed since the last call are read.
+    static result_t<std::vector<std::map<std::string, file_stats_t>>> stats(const std::filesystem::path& root);
+
+    // Every solution, stray file and unexpected folder under root.
+    static result_t<layout_t> layout(const std::filesystem::path& root);
+
+    // Moves that bring inv in line with current, the levels from
+    // client_t::lookup. Solutions missing from current move to Unrated.
+    static std::vector<move_t> plan_patch(const inventory_t& inv, const std::vector<problem_t>& current);
+
+    // Rename every file of moves under root, and the "<id>/" sample folder
+    // beside them, reporting each one to on_move as it is done. A move that
+    // fails is undone before it is reported.
+    static std::vector<applied_t> apply_patch(
+        const std::filesystem::path& root, const std::vector<move_t>& moves,
+        const std::function<void(const applied_t&)>& on_move = { }
+    );
+
+    // One check_t per solved problem, by id, with duplicates dropped.
+    // Unrated problems are never selected.
+    static std::vector<check_t> plan_update(
+        const inventory_t& inv, std::vector<problem_t> solved, const tier_range& filter
+    );
+
+    // <root>/<tier folder>/<id>.<ext>
+    static std::filesystem::path solution_path(
+        const std::filesystem::path& root, i32 id, tier_t t, std::string_view ext
+    );
+
+    // Create an empty file at p, and its parent folders. An existing file
+    // is a failure unless overwrite is set, in which case it is truncated.
+    static failure_t create(const std::filesystem::path& p, bool overwrite = false);
+};
+
+// Asynchronous solved.ac client.
+//
+// Requests are queued to one worker thread that owns a persistent HTTP
+// connection and are served in order. Every call has a future form and a
+// callback form; callbacks run on the worker thread. Problems fetched
+// through show() and problem() are cached for ten minutes. Destroying the
+// client finishes the requests already queued.
+class client_t {
+public:
+    template <typename T>
+    using callback_t = std::function<void(result_t<T>)>;
+    // Called on the worker thread with each page as it arrives, and the
+    // number of problems expected in total.
+    using batch_t = std::function<void(const std::vector<problem_t>& batch, std::size_t total)>;
+
+    // BJMGR_API_URL, else the public solved.ac API.
+    static std::string default_api_url();
+
+    explicit client_t(std::string __api_url = default_api_url());
+    client_t(const client_t&) = delete;
+    client_t& operator=(const client_t&) = delete;
+    ~client_t();
+
+    const std::string& api_url() const { return _api_url; }
+
+    // problem/show for one problem.
+    std::future<result_t<problem_t>> show(i32 id);
+    void show(i32 id, callback_t<problem_t> done);
+
+    // One problem, from the cache when possible. Requests made before the
+    // worker gets to them are coalesced into problem/lookup calls of up to
+    // 100 ids. An id solved.ac does not know fails with status 404.
+    std::future<result_t<problem_t>> problem(i32 id);
+    void problem(i32 id, callback_t<problem_t> done);
+
+    // problem/lookup in batches of 100, results in the order of ids.
+    std::future<result_t<std::vector<problem_t>>> lookup(std::vector<i32> ids, batch_t on_batch = { });
+    void lookup(std::vector<i32> ids, batch_t on_batch, callback_t<std::vector<problem_t>> done);
+
+    // Every problem user has solved, 50 per page.
+    std::future<result_t<std::vector<problem_t>>> solved(std::string user, batch_t on_batch = { });
+    void solved(std::string user, batch_t on_batch, callback_t<std::vector<problem_t>> done);
+
+private:
+    struct worker;
+
+    void submit(std::function<void(worker&)> job);
+
+    std::string _api_url;
+    std::unique_ptr<worker> _worker;
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <filesystem>
+
+#include "intdef.h"
+#include "tier.h"
+#include "problem.h"
+
+// Offline copy of problem titles, levels and tags, searchable by substring
+// and by tag.
+//
+// The file holds the trigram table of the normalized titles (UTF-8
+// characters, ASCII lowercased, whitespace collapsed), the tag table, one
+// sorted posting list of problem indices per trigram and per tag, the
+// problems sorted by id as columns (id, level, solver count, title) and
+// the title and tag text. It is mapped read-only and used in place: a
+// search binary searches the trigram table, intersects the posting lists
+// of the query's trigrams and checks the few candidates left, and nothing
+// is built when the file is opened.
+class catalog_t {
+public:
+    struct entry_t {
+        i32 id;
+        tier_t tier;
+        u32 solvers;
+        std::string_view title;
+    };
+
+    // Ascending problem indices.
+    struct list_t {
+        const u32 *b = nullptr, *e = nullptr;
+
+        const u32* begin() const { return b; }
+        const u32* end() const { return e; }
+        std::size_t size() const { return e - b; }
+    };
+
+    // BJMGR_CATALOG, else $XDG_CACHE_HOME/bjmgr/catalog, else
+    // ~/.cache/bjmgr/catalog.
+    static std::filesystem::path default_path();
+
+    // Map the catalog at path. A missing or damaged file reads as empty.
+    explicit catalog_t(const std::filesystem::path& __path = default_path());
+    catalog_t(const catalog_t&) = delete;
+    catalog_t& operator=(const catalog_t&) = delete;
+    ~catalog_t();
+
+    bool empty() const { return !_n; }
+    u32 size() const { return _n; }
+
+    // i-th problem in id order.
+    entry_t at(u32 i) const;
+
+    // Index of problem id, or -1.
+    i32 find(i32 id) const;
+
+    // Columns of size(), for code that scores every problem at once.
+    const i32* ids() const { return _ids; }
+    const u8* levels() const { return _levels; }
+    const u32* solvers() const { return _solvers; }
+
+    // Tags sorted by key.
+    u32 tag_count() const { return _ntag; }
+    std::string_view tag(u32 t) const;
+    list_t tagged(u32 t) const;
+
+    // Index of the tag with this key, or -1.
+    i32 find_tag(std::string_view key) const;
+
+    // Indices of the problems whose title contains text, in id order.
+    // Matching uses the same normalization as the index.
+    std::vector<u32> search(std::string_view text) const;
+
+    // Add ps to the catalog at path, replacing entries with the same id,
+    // and rewrite it atomically if anything changed. Problems without a
+    // title are ignored; the tags of the newest fetch win. false if the
+    // file could not be written.
+    static bool merge(const std::filesystem::path& path, const std::vector<problem_t>& ps);
+
+    // On-disk records, defined in catalog.cpp.
+    struct tri_rec;
+    struct tag_rec;
+
+private:
+    void* _map = nullptr;
+    std::size_t _len = 0;
+
+    u32 _n = 0, _ntri = 0, _ntag = 0;
+    const tri_rec* _tris = nullptr;
+    const tag_rec* _tags = nullptr;
+    const i32* _ids = nullptr;
+    const u32* _solvers = nullptr;
+    const u32* _title_off = nullptr;
+    const u32* _post = nullptr;
+    const u8* _levels = nullptr;
+    const char* _text = nullptr;
+};
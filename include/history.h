@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include <filesystem>
+
+#include "intdef.h"
+#include "tier.h"
+#include "bjmgr.h"
+
+// Level changes applied by patch, kept in <root>/.bjmgr/history.
+//
+// The file only grows: every patch run appends one block of the changes it
+// applied, stamped with the run's time. A block is a small header followed
+// by its columns (ids ascending as varint deltas, old levels, new levels),
+// so a year of nightly runs with a handful of changes each stays within a
+// few kilobytes. Queries walk the block headers and skip the columns of
+// blocks outside the time range.
+class history_t {
+public:
+    struct change_t {
+        i64 ts;                 // unix time in seconds
+        i32 id;
+        tier_t from, to;
+    };
+
+    static std::filesystem::path path_for(const std::filesystem::path& root);
+
+    // Map the history at path. A missing file reads as empty, and a block
+    // cut short by a crash ends it.
+    explicit history_t(const std::filesystem::path& __path);
+    history_t(const history_t&) = delete;
+    history_t& operator=(const history_t&) = delete;
+    ~history_t();
+
+    bool empty() const { return !_valid; }
+
+    // Changes with from <= ts < to, oldest first. Only ids, if not empty
+    // and sorted, are kept.
+    std::vector<change_t> range(i64 from, i64 to, const std::vector<i32>& ids = { }) const;
+
+    // Append the moves of one run at ts. Nothing is written for none, and
+    // a torn block left by an earlier crash is cut off first. false if the
+    // file could not be written.
+    static bool append(const std::filesystem::path& path, i64 ts, std::vector<move_t> moves);
+
+private:
+    const u8* _map = nullptr;
+    std::size_t _len = 0;
+
+    // Bytes up to the end of the last complete block.
+    std::size_t _valid = 0;
+};
@@ -3,4 +3,8 @@
 #include <cstdio>
 #include <termios.h>
 
-int getch(bool echo);
\ No newline at end of file
+// Read one key from the input descriptor without waiting for Enter.
+int getch(bool echo);
+// Descriptor getch() reads from; stdin unless changed.
+void set_input_fd(int fd);
+int input_fd();
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <filesystem>
+
+#include "intdef.h"
+#include "tier.h"
+
+// Compiles solutions and runs them against their local sample tests.
+//
+// Samples live next to the solution, in "<level folder>/<id>/" as pairs of
+// "<name>.in" and "<name>.out". Binaries are cached by a hash of the
+// compiler, its version, the flags and the source, so a solution is only
+// rebuilt when one of them changes. Compiles share one precompiled
+// <bits/stdc++.h>, built once per compiler and flags.
+//
+// bench() times a binary on every sample input instead, and its results
+// are kept in <root>/.bjmgr/bench by the binary's hash, so a rewrite can
+// be compared with the build before it.
+class judge {
+public:
+    struct options_t {
+        std::string cxx;
+        std::vector<std::string> flags;
+        // 0 for one per core.
+        i32 jobs = 0;
+        i64 timeout_ms = 5000;
+    };
+
+    struct target_t {
+        i32 id;
+        tier_t tier;
+        u32 langs;      // lang mask, as in inventory_t
+    };
+
+    struct case_t {
+        enum verdict_t : u8 { pass, wrong, crash, timeout };
+
+        std::string name;
+        verdict_t verdict;
+        i64 ms;
+        // wrong: the first line that differs, from each side.
+        std::string expected, got;
+    };
+
+    struct report_t {
+        // cached and built ran the cases; failed holds the compiler output
+        // in log, and no_source means there is no C++ file to build.
+        enum build_t : u8 { cached, built, failed, no_source };
+
+        target_t target;
+        build_t build;
+        std::string log;
+        std::vector<case_t> cases;
+    };
+
+    struct bench_options_t {
+        i32 runs = 10, warmup = 2;
+        // Pinned to this CPU, if not -1.
+        i32 cpu = -1;
+    };
+
+    // One input timed by bench(). Times are in microseconds.
+    struct timing_t {
+        std::string name;
+        // Every run exited with 0.
+        bool ok;
+        i64 wall_med, wall_p95;
+        i64 cpu_med, cpu_p95;       // user + system
+        i64 rss_kb;                 // largest of the runs
+        // Medians of instructions, cycles, cache misses and branch misses,
+        // or -1 when perf_event_open is not permitted.
+        i64 counters[4];
+    };
+
+    struct bench_t {
+        // Timings are only taken for the cached and built outcomes.
+        report_t report;
+        std::string hash;
+        std::vector<timing_t> inputs;
+    };
+
+    // A timing kept by save_bench().
+    struct saved_t {
+        i32 id;
+        std::string hash;
+        i64 ts;
+        timing_t timing;
+    };
+
+    // $CXX or g++, and $BJMGR_CXXFLAGS or the flags BOJ judges C++17 with.
+    static options_t default_options();
+
+    // BJMGR_BUILD_CACHE, else $XDG_CACHE_HOME/bjmgr/build, else
+    // ~/.cache/bjmgr/build.
+    static std::filesystem::path cache_dir();
+
+    // Version line of the compiler, or "" if it cannot be run.
+    static std::string compiler_version(const options_t& opts);
+
+    // Build and test targets on a pool of opts.jobs threads. on_done is
+    // called as each target finishes, one call at a time. Reports come
+    // back in the order of targets.
+    static std::vector<report_t> run(
+        const std::filesystem::path& root, const std::vector<target_t>& targets,
+        const options_t& opts, const std::function<void(const report_t&)>& on_done = { }
+    );
+
+    // Last CPU this process may run on, or -1.
+    static i32 default_cpu();
+
+    // cpu is one this process may run on.
+    static bool cpu_allowed(i32 cpu);
+
+    // Build t and run it warmup + runs times on each "<id>/<name>.in",
+    // pinned to bopts.cpu. Hardware counters are read when the kernel
+    // permits it.
+    static bench_t bench(
+        const std::filesystem::path& root, const target_t& t,
+        const options_t& opts, const bench_options_t& bopts
+    );
+
+    static std::filesystem::path bench_path(const std::filesystem::path& root);
+
+    // Saved timings, oldest first. A missing or unknown file reads as
+    // empty.
+    static std::vector<saved_t> load_bench(const std::filesystem::path& root);
+
+    // Keep the timings of one build of id, replacing those of the same
+    // hash. false if the file could not be written.
+    static bool save_bench(
+        const std::filesystem::path& root, i32 id, const std::string& hash, i64 ts,
+        const std::vector<timing_t>& inputs
+    );
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <string_view>
+
+#include "intdef.h"
+
+// Perfect over lang::table; the static_assert there keeps it so.
+constexpr u32 lang_hash(std::string_view s)
+{ return (u32)((u8)s[0] + (u8)s.back() * 23 + s.size() * 3) & 63; }
+
+// Registry of solution file extensions.
+//
+// Each extension is one entry, and its index is the bit it sets in a
+// problem's language mask, so a mask names the exact files to move. The
+// index caches masks, so entries are only ever appended. Several
+// extensions may share a language name ("cc" and "cpp" are both C++).
+class lang {
+public:
+    struct entry_t {
+        std::string_view ext, name;
+    };
+
+    static constexpr entry_t table[] = {
+        { "c", "C" }, { "cc", "C++" }, { "cpp", "C++" }, { "cxx", "C++" },
+        { "cs", "C#" }, { "d", "D" }, { "go", "Go" }, { "hs", "Haskell" },
+        { "java", "Java" }, { "js", "JavaScript" }, { "kt", "Kotlin" }, { "lua", "Lua" },
+        { "ml", "OCaml" }, { "pl", "Perl" }, { "php", "PHP" }, { "py", "Python" },
+        { "rb", "Ruby" }, { "rs", "Rust" }, { "scala", "Scala" }, { "swift", "Swift" },
+        { "ts", "TypeScript" }
+    };
+
+    static constexpr i32 count = (i32)std::size(table);
+    static_assert(count <= 32, "language masks are 32 bits");
+
+    // Entry of an extension without the dot, or -1: one hash and one
+    // compare.
+    static constexpr i32 of(std::string_view ext) {
+        if (ext.empty()) return -1;
+
+        i8 i = slots[lang_hash(ext)];
+        return i >= 0 && table[i].ext == ext ? i : -1;
+    }
+
+    static constexpr u32 bit(std::string_view ext) {
+        i32 i = of(ext);
+        return i < 0 ? 0 : 1u << i;
+    }
+
+private:
+    static constexpr std::array<i8, 64> slots = [] {
+        std::array<i8, 64> t { };
+        for (auto& x : t) x = -1;
+
+        for (i32 i = 0; i < count; i++) {
+            auto& x = t[lang_hash(table[i].ext)];
+            x = x == -1 ? i : -2;
+        }
+
+        return t;
+    }();
+
+    static_assert([] {
+        for (auto x : slots) if (x == -2) return false;
+        return true;
+    }(), "lang_hash has a collision");
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
+#include <filesystem>
+
+#include "intdef.h"
+
+enum class log_phase : u8 {
+    run, fetch, diff, patch, check, create
+};
+
+enum class log_result : u8 {
+    ok, fail, skip, cancel, invalid, present, missing
+};
+
+struct log_record {
+    log_record() = default;
+    log_record(
+        log_phase __phase, log_result __result, i32 __id = 0,
+        i32 __old = -1, i32 __new = -1, std::string __msg = ""
+    ) : phase(__phase), result(__result), id(__id),
+        old_level(__old), new_level(__new), msg(std::move(__msg)) { }
+
+    i64 ts = 0;                 // unix time in milliseconds, filled by push()
+    log_phase phase = log_phase::run;
+    log_result result = log_result::ok;
+    i32 id = 0;                 // 0 : no problem attached
+    i8 old_level = -1;          // -1 : not set
+    i8 new_level = -1;
+    std::string msg;
+};
+
+// Background log writer for patch/update.
+//
+// Producers push records onto an unbounded lock-free MPSC queue and return
+// immediately; a worker thread drains it, renders each record as one NDJSON
+// line (or as the colored plain-text view) and writes in large batches.
+// The idle worker sleeps on a condition variable, and push() only takes
+// the lock to wake it.
+// Sinks still open at exit() are drained by an atexit hook, so error paths
+// that bail out early keep their last records.
+class log_sink {
+public:
+    enum class format { json, text };
+
+    log_sink(const std::filesystem::path& __path, format __fmt = format::text);
+    log_sink(const log_sink&) = delete;
+    log_sink& operator=(const log_sink&) = delete;
+    ~log_sink();
+
+    void push(log_record r);
+
+    // Drain everything pushed so far and stop the worker.
+    void close();
+
+    static bool parse_format(const std::string& s, format& f);
+
+private:
+    struct node {
+        std::atomic<node*> next { nullptr };
+        log_record rec;
+    };
+
+    void run();
+    void wake();
+    bool drain(std::string& out);
+    void render(const log_record& r, std::string& out) const;
+
+    std::ofstream _out;
+    format _fmt;
+
+    std::atomic<node*> _head;
+    node* _tail;
+
+    std::atomic<bool> _stop { false };
+    // Set while the worker waits, so push() knows to notify.
+    std::atomic<bool> _waiting { false };
+    std::mutex _mtx;
+    std::condition_variable _cv;
+    std::thread _th;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+
+#include "intdef.h"
+
+// Run metrics exported in Prometheus textfile-collector format.
+//
+// Everything is kept in process memory and written once when the process
+// exits, to a temporary file renamed over the target so a scraping node
+// exporter never sees a partial file.
+class metrics {
+public:
+    static bool enabled() { return _on.load(std::memory_order_relaxed); }
+
+    static void start(const std::string& path, const std::string& command);
+
+    // Local inventory size per tier level, from get_list().
+    static void tier_counts(const std::vector<std::vector<i32>>& ps);
+
+    static void diffs(u64 n);
+    static void created(u64 n = 1);
+    static void http(f64 seconds, long status, u64 bytes);
+    static void phase(const char* name, f64 seconds);
+
+    // Marks the run as completed; runs that exit early report 0.
+    static void success();
+
+private:
+    static void finish();
+
+    static std::atomic<bool> _on;
+};
+
+// Measures a named phase while metrics are enabled.
+class metrics_phase {
+public:
+    using clock = std::chrono::steady_clock;
+
+    explicit metrics_phase(const char* __name)
+    : _name(__name), _on(metrics::enabled()) { if (_on) _start = clock::now(); }
+    metrics_phase(const metrics_phase&) = delete;
+    metrics_phase& operator=(const metrics_phase&) = delete;
+
+    ~metrics_phase() {
+        if (_on) metrics::phase(_name, std::chrono::duration<f64>(clock::now() - _start).count());
+    }
+
+private:
+    const char* _name;
+    bool _on;
+    clock::time_point _start;
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <charconv>
+#include <type_traits>
+
+#include <cstddef>
+
+#include "intdef.h"
+
+// Buffered writer on a raw file descriptor.
+//
+// Text is appended into a preallocated buffer and numbers are formatted in
+// place with std::to_chars, so the buffer only reaches write(2) when it is
+// full or flush() is called. A tied writer is flushed before this one starts
+// buffering, which keeps stdout/stderr ordered on a terminal.
+class writer_t {
+public:
+    explicit writer_t(int __fd, std::size_t __cap = 1 << 16, writer_t* __tie = nullptr);
+    writer_t(const writer_t&) = delete;
+    writer_t& operator=(const writer_t&) = delete;
+    ~writer_t();
+
+    writer_t& operator<<(std::string_view s) { return write(s.data(), s.size()); }
+    writer_t& operator<<(const char* s) { return *this << std::string_view(s); }
+    writer_t& operator<<(const std::string& s) { return *this << std::string_view(s); }
+    writer_t& operator<<(char c) { prepare(1); _buf[_len++] = c; return *this; }
+
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+    writer_t& operator<<(T n) { return num(n); }
+
+    // Right-aligned number padded with spaces to `width` (like std::setw).
+    template <typename T>
+    writer_t& num(T n, i32 width = 0) {
+        char tmp[24];
+        auto [e, ec] = std::to_chars(tmp, tmp + sizeof(tmp), n);
+        i32 sz = (i32)(e - tmp);
+
+        if (width > sz) fill(' ', width - sz);
+        return write(tmp, sz);
+    }
+
+    // Left-aligned text padded with `c` to `width`.
+    writer_t& pad_right(std::string_view s, i32 width, char c = ' ')
+    { *this << s; return fill(c, width - (i32)s.size()); }
+
+    writer_t& fill(char c, i32 cnt);
+    writer_t& write(const char* s, std::size_t n);
+
+    void flush();
+
+    int fd() const { return _fd; }
+    // Flush and continue on another descriptor.
+    void redirect(int __fd) { flush(); _fd = __fd; }
+
+private:
+    void prepare(std::size_t n);
+
+    std::unique_ptr<char[]> _buf;
+    std::size_t _cap, _len = 0;
+    int _fd;
+    writer_t* _tie;
+};
+
+// Process-wide writers for stdout and stderr. berr is tied to bout.
+extern writer_t bout, berr;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "tier.h"
 #include "intdef.h"
@@ -10,4 +11,33 @@ struct problem_t {
     i32 id;
 
     tier_t tier;
-};
\ No newline at end of file
+
+    // Users who solved it, as reported by solved.ac.
+    u32 solvers = 0;
+
+    // solved.ac tag keys, e.g. "dp" or "graphs".
+    std::vector<std::string> tags;
+};
+
+// Problem id and level code packed into one word.
+//
+// The level sits in the top 5 bits, so comparing raw values orders
+// records by (tier, id) and sorting an inventory is a plain u32 sort.
+struct record_t {
+    static constexpr u32 id_bits = 27;
+    static constexpr u32 id_mask = (1u << id_bits) - 1;
+
+    constexpr record_t() = default;
+    constexpr record_t(i32 __id, tier_t __t)
+    : raw((u32)__t.code << id_bits | ((u32)__id & id_mask)) { }
+
+    u32 raw = 0;
+
+    constexpr i32 id() const { return raw & id_mask; }
+    constexpr tier_t tier() const { return tier_t((i32)(raw >> id_bits)); }
+
+    constexpr bool operator<(const record_t& r) const { return raw < r.raw; }
+    constexpr bool operator==(const record_t& r) const { return raw == r.raw; }
+};
+
+static_assert(sizeof(record_t) == 4);
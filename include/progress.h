@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include "intdef.h"
+
+// Progress line redrawn at a fixed rate from its own thread.
+//
+// Work loops only bump the atomic counters; the reporter samples them,
+// computes throughput and ETA and rewrites a single terminal line.
+// Nothing is drawn when stdout is not a TTY.
+class progress_t {
+public:
+    using clock = std::chrono::steady_clock;
+
+    explicit progress_t(
+        std::string_view __label, u64 __total = 0,
+        std::chrono::milliseconds __interval = std::chrono::milliseconds(100)
+    );
+    progress_t(const progress_t&) = delete;
+    progress_t& operator=(const progress_t&) = delete;
+    ~progress_t();
+
+    void add(u64 n = 1) { _done.fetch_add(n, std::memory_order_relaxed); }
+    void set_total(u64 n) { _total.store(n, std::memory_order_relaxed); }
+
+    // Stops the reporter and prints the final "<label>... Done." line.
+    void finish();
+
+private:
+    void run();
+    void draw();
+
+    std::string _label;
+    std::atomic<u64> _done { 0 }, _total;
+    std::chrono::milliseconds _interval;
+    clock::time_point _start;
+
+    bool _tty, _stop = false;
+    std::mutex _mtx;
+    std::condition_variable _cv;
+    std::thread _th;
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "intdef.h"
+
+// Background server for the quick commands.
+//
+// `bjmgr daemon` listens on a Unix socket and runs forwarded command lines
+// in its own process, so the workspace index, problem metadata and the
+// connection to solved.ac stay warm between invocations. The client hands
+// over its stdin/stdout/stderr with the request, so output and prompts go
+// straight to the caller's terminal. Requests are served one at a time.
+class service {
+public:
+    // Runs one forwarded command line in the daemon's process and returns
+    // its exit status. argv[0] is the program name.
+    using handler_t = i32 (*)(const std::string& cwd, std::vector<std::string>& argv, const int fds[3]);
+
+    // BJMGR_SOCKET, else $XDG_RUNTIME_DIR/bjmgr.sock, else /tmp/bjmgr-<uid>.sock.
+    static std::string socket_path();
+
+    // Send the command line to a running daemon and wait for its exit
+    // status. false when no daemon is listening, so the caller runs the
+    // command itself.
+    static bool forward(i32 argc, char** argv, i32& status);
+
+    // Serve until SIGINT/SIGTERM. Returns non-zero if the socket cannot be
+    // set up, e.g. because another daemon already owns it.
+    static i32 serve(const std::string& path, handler_t handler);
+};
@@ -1,14 +1,21 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <numeric>
 #include <vector>
-#include <sstream>
-#include <functional>
+#include <charconv>
+#include <iterator>
 #include <type_traits>
 #include <algorithm>
 
+#include <cctype>
 #include <cstddef>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 class strlib {
 private:
@@ -36,83 +43,157 @@ public:
         return pos;
     }
 
-    template <typename ForwardIterator, typename = StringTemplate<ForwardIterator>>
-    inline static std::string join(ForwardIterator b, ForwardIterator e, const std::string& delim = "") {
-        if (b == e) return "";
+    // Append v to out; integers are formatted in place without a temporary.
+    template <typename T>
+    inline static void append(std::string& out, const T& v) {
+        if constexpr (std::is_integral_v<T>) {
+            char b[24];
+            auto r = std::to_chars(b, b + sizeof(b), v);
+            out.append(b, r.ptr - b);
+        } else out += std::string_view(v);
+    }
+
+    // Append the elements in [b, e) to out separated by delim. String-like
+    // elements are measured first so out grows exactly once.
+    template <typename ForwardIterator>
+    inline static std::string& append_join(std::string& out, ForwardIterator b, ForwardIterator e, std::string_view delim = "") {
+        if (b == e) return out;
 
-        std::string output = *b;
+        using T = typename std::iterator_traits<ForwardIterator>::value_type;
 
-        for (b++; b != e; b++)
-            output += delim + *b;
-        
-        return output;
+        if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            std::size_t n = out.size(), k = 0;
+            for (auto i = b; i != e; i++, k++) n += std::string_view(*i).size();
+            out.reserve(n + (k - 1) * delim.size());
+        }
+
+        append(out, *b);
+
+        for (b++; b != e; b++) {
+            out += delim;
+            append(out, *b);
+        }
+
+        return out;
+    }
+
+    // As above with each element passed through conv first. conv may return
+    // a string, a string_view or an integer.
+    template <typename ForwardIterator, typename Conv, typename = std::enable_if_t<!std::is_convertible_v<Conv, std::string_view>>>
+    inline static std::string& append_join(std::string& out, ForwardIterator b, ForwardIterator e, Conv conv, std::string_view delim = "") {
+        if (b == e) return out;
+
+        append(out, conv(*b));
+
+        for (b++; b != e; b++) {
+            out += delim;
+            append(out, conv(*b));
+        }
+
+        return out;
     }
 
     template <typename ForwardIterator>
-    inline static std::string join(ForwardIterator b, ForwardIterator e, std::function<std::string (const typename std::iterator_traits<ForwardIterator>::value_type&)> conv, const std::string& delim = "") {
-        if (b == e) return "";
+    inline static std::string join(ForwardIterator b, ForwardIterator e, std::string_view delim = "")
+    { std::string output; append_join(output, b, e, delim); return output; }
+
+    template <typename ForwardIterator, typename Conv, typename = std::enable_if_t<!std::is_convertible_v<Conv, std::string_view>>>
+    inline static std::string join(ForwardIterator b, ForwardIterator e, Conv conv, std::string_view delim = "")
+    { std::string output; append_join(output, b, e, conv, delim); return output; }
 
-        std::string output = conv(*b);
+    // Occurrences of c in src. With SSE2, 16 bytes are compared at a time
+    // and the matches summed in byte lanes, flushed every 255 blocks.
+    inline static std::size_t count(std::string_view src, char c) {
+        const char* p = src.data(), * e = p + src.size();
+        std::size_t n = 0;
 
-        for (b++; b != e; b++)
-            output += delim + conv(*b);
+#if defined(__SSE2__)
+        const __m128i k = _mm_set1_epi8(c), z = _mm_setzero_si128();
 
-        return output;
+        while (e - p >= 16) {
+            std::size_t blocks = std::min<std::size_t>((e - p) / 16, 255);
+            __m128i acc = z;
+
+            for (std::size_t i = 0; i < blocks; i++, p += 16)
+                acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), k));
+
+            __m128i sum = _mm_sad_epu8(acc, z);
+            n += _mm_extract_epi16(sum, 0) + _mm_extract_epi16(sum, 4);
+        }
+#endif
+
+        for (; p != e; p++) n += *p == c;
+
+        return n;
+    }
+
+    // Call f with a view of every token in src. Same tokens as std::getline:
+    // empty fields are kept, but a trailing delimiter does not start a new one.
+    template <typename UnaryFunc>
+    inline static void split_views(std::string_view src, char delim, UnaryFunc f) {
+        const char* p = src.data(), * e = p + src.size();
+
+        while (p != e) {
+            auto q = static_cast<const char*>(std::memchr(p, delim, e - p));
+
+            if (!q) { f(std::string_view(p, e - p)); break; }
+
+            f(std::string_view(p, q - p));
+            p = q + 1;
+        }
     }
 
     template <typename ForwardIterator, typename = StringTemplate<ForwardIterator>>
     [[ deprecated ]]
-    inline static size_t split(const std::string& src, ForwardIterator dest, char delim)
-    { size_t c = 0; std::stringstream ss(src); for (std::string s; std::getline(ss, s, delim); c++, dest++) *dest = s; return c; }
+    inline static size_t split(std::string_view src, ForwardIterator dest, char delim)
+    { size_t c = 0; split_views(src, delim, [&] (std::string_view s) { *dest = std::string(s); dest++; c++; }); return c; }
 
     [[ deprecated ]]
-    inline static void split(const std::string& src, std::vector<std::string>& dest, char delim)
-    { std::stringstream ss(src); for (std::string s; std::getline(ss, s, delim); dest.push_back(s)); }
+    inline static void split(std::string_view src, std::vector<std::string>& dest, char delim)
+    { split_views(src, delim, [&] (std::string_view s) { dest.emplace_back(s); }); }
 
     template <typename OutT, typename UnaryOp>
     [[ deprecated ]]
-    inline static std::vector<OutT> split_map(const std::string& __src, UnaryOp __unary_op, char __delim) {
-        std::stringstream ss(__src);
+    inline static std::vector<OutT> split_map(std::string_view __src, UnaryOp __unary_op, char __delim) {
         std::vector<OutT> v;
-        std::string s;
-
-        while (std::getline(ss, s, __delim))
-            v.push_back(__unary_op(s));
+        split_views(__src, __delim, [&] (std::string_view s) { v.push_back(call_token(__unary_op, s)); });
 
         return v;
     }
 
+    // Tokens are constructed from views, so std::vector<std::string_view>
+    // gets views into src without copying.
     template <typename _Container>
-    inline static _Container split(const std::string& __src, char __delim) {
-        std::stringstream ss(__src);
+    inline static _Container split(std::string_view __src, char __delim) {
         _Container ct; auto iter = std::back_inserter(ct);
-        std::string s;
 
-        while (getline(ss, s, __delim))
-            iter = s;
+        split_views(__src, __delim, [&] (std::string_view s) {
+            iter = typename _Container::value_type(s);
+        });
 
         return ct;
     }
 
     template <typename _Container, typename UnaryOp>
-    inline static _Container split_map(const std::string& __src, char __delim, UnaryOp __unary_op) {
-        std::stringstream ss(__src);
+    inline static _Container split_map(std::string_view __src, char __delim, UnaryOp __unary_op) {
         _Container ct; auto iter = std::back_inserter(ct);
-        std::string s;
-
-        while (std::getline(ss, s, __delim))
-            iter = __unary_op(s);
+        split_views(__src, __delim, [&] (std::string_view s) { iter = call_token(__unary_op, s); });
 
         return ct;
     }
 
-    template <typename UnaryFunc>
-    inline static void split_foreach(const std::string& __src, char __delim, UnaryFunc __unary_func) {
-        std::stringstream ss(__src);
-        std::string s;
+    // f(s) when f takes a view, else f with a std::string lvalue, as the
+    // getline based versions passed.
+    template <typename Func>
+    inline static decltype(auto) call_token(Func& f, std::string_view s) {
+        if constexpr (std::is_invocable_v<Func&, std::string_view>) return f(s);
+        else { std::string t(s); return f(t); }
+    }
 
-        while (std::getline(ss, s, __delim))
-            __unary_func(s);
+    // Views are passed when __unary_func takes one, std::string otherwise.
+    template <typename UnaryFunc>
+    inline static void split_foreach(std::string_view __src, char __delim, UnaryFunc __unary_func) {
+        split_views(__src, __delim, [&] (std::string_view s) { call_token(__unary_func, s); });
     }
 
     // Remove character if predict return false.
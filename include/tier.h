@@ -1,196 +1,253 @@
 #pragma once
 
-#include <string>
+#include <array>
+#include <string_view>
 #include <tuple>
 
 #include "intdef.h"
 
+// A solved.ac level stored as its level code in one byte.
+//
+// 0 is Unrated (also used for anything that fails to parse), 1..30 run
+// from Bronze 5 to Ruby 1. Every name, path and color escape is a
+// constexpr table indexed by that code.
 struct tier_t {
-    tier_t() = default;
-    tier_t(const tier_t&) = default;
-    tier_t(tier_t&&) = default;
-
-    tier_t(char t, i32 l)
-    { set_tier(t); set_level(l); }
-    tier_t(i32 n) {
-        if (n == 0) { tier = '\0', level = 0; return; }
-        set_tier("BSGPDR"[(n - 1) / 5]); set_level(5 - (n - 1) % 5);
-    }
-    tier_t(const std::string& s) {
-        if (s.size() < 2) { tier = '\0', level = 0; return; }
-        
-        set_tier(std::toupper(s[0])); set_level(s.back() - '0');
-    }
-
-    char tier;
-    i32 level;
-
-private:
-    const static std::tuple<i32, i32, i32> color_table[31];
-
-public:
-    void set_tier(char c) {
-        if (c == 'B' || c == 'S' || c == 'G' || c == 'P' || c == 'D' || c == 'R')
-            tier = c;
-        else tier = '\0';
-    }
-
-    void set_level(i32 l) {
-        if (l >= 0 && l <= 5) level = l;
-        else level = -1;
-    }
-
-    char get_tier() const { return tier; }
-    i32 get_level() const { return level; }
+    constexpr tier_t() = default;
+    constexpr tier_t(const tier_t&) = default;
+    constexpr tier_t(tier_t&&) = default;
 
-    bool valid() const { return tier != '\0' && level != -1; }
+    constexpr tier_t(char t, i32 l)
+    : code(encode(t, l)) { }
+    constexpr tier_t(i32 n)
+    : code(0 <= n && n <= 30 ? n : 0) { }
+    // "G3", "g3" or a folder name such as "Gold 3".
+    constexpr tier_t(std::string_view s)
+    : code(s.size() < 2 ? 0 : encode(s[0], s.back() - '0')) { }
 
-    std::string short_name() const
-    { return (valid() ? std::string(1, tier) + (char)(this->level + '0') : "U"); }
+    u8 code = 0;
 
-    std::string long_name() const
-    { return tier_name() + (valid() ? std::string(" ") + (char)(this->level + '0') : ""); }
-
-    std::string tier_name() const {
-        if (!valid()) return "Unrated";
-
-        switch (this->tier) {
-            case 'B': return "Bronze";
-            case 'S': return "Silver";
-            case 'G': return "Gold";
-            case 'P': return "Platinum";
-            case 'D': return "Diamond";
-            case 'R': return "Ruby";
+private:
+    static constexpr std::array<i8, 256> letter_table = [] {
+        std::array<i8, 256> t { };
+        for (auto& x : t) x = -1;
+
+        const char* up = "BSGPDR", * lo = "bsgpdr";
+        for (i32 i = 0; i < 6; i++) t[(u8)up[i]] = t[(u8)lo[i]] = i;
+
+        return t;
+    }();
+
+    static constexpr char tier_table[31] = {
+        '\0',
+        'B', 'B', 'B', 'B', 'B', 'S', 'S', 'S', 'S', 'S',
+        'G', 'G', 'G', 'G', 'G', 'P', 'P', 'P', 'P', 'P',
+        'D', 'D', 'D', 'D', 'D', 'R', 'R', 'R', 'R', 'R'
+    };
+
+    static constexpr std::string_view name_table[7] = {
+        "Unrated", "Bronze", "Silver", "Gold", "Platinum", "Diamond", "Ruby"
+    };
+
+    static constexpr std::string_view short_table[31] = {
+        "U",
+        "B5", "B4", "B3", "B2", "B1", "S5", "S4", "S3", "S2", "S1",
+        "G5", "G4", "G3", "G2", "G1", "P5", "P4", "P3", "P2", "P1",
+        "D5", "D4", "D3", "D2", "D1", "R5", "R4", "R3", "R2", "R1"
+    };
+
+    static constexpr std::string_view long_table[31] = {
+        "Unrated",
+        "Bronze 5", "Bronze 4", "Bronze 3", "Bronze 2", "Bronze 1",
+        "Silver 5", "Silver 4", "Silver 3", "Silver 2", "Silver 1",
+        "Gold 5", "Gold 4", "Gold 3", "Gold 2", "Gold 1",
+        "Platinum 5", "Platinum 4", "Platinum 3", "Platinum 2", "Platinum 1",
+        "Diamond 5", "Diamond 4", "Diamond 3", "Diamond 2", "Diamond 1",
+        "Ruby 5", "Ruby 4", "Ruby 3", "Ruby 2", "Ruby 1"
+    };
+
+    static constexpr std::string_view path_table[31] = {
+        "Unrated",
+        "Bronze/Bronze 5", "Bronze/Bronze 4", "Bronze/Bronze 3", "Bronze/Bronze 2", "Bronze/Bronze 1",
+        "Silver/Silver 5", "Silver/Silver 4", "Silver/Silver 3", "Silver/Silver 2", "Silver/Silver 1",
+        "Gold/Gold 5", "Gold/Gold 4", "Gold/Gold 3", "Gold/Gold 2", "Gold/Gold 1",
+        "Platinum/Platinum 5", "Platinum/Platinum 4", "Platinum/Platinum 3", "Platinum/Platinum 2", "Platinum/Platinum 1",
+        "Diamond/Diamond 5", "Diamond/Diamond 4", "Diamond/Diamond 3", "Diamond/Diamond 2", "Diamond/Diamond 1",
+        "Ruby/Ruby 5", "Ruby/Ruby 4", "Ruby/Ruby 3", "Ruby/Ruby 2", "Ruby/Ruby 1"
+    };
+
+    static constexpr std::tuple<i32, i32, i32> color_table[31] = {
+        // Unrated
+        {  45,  45,  45 },
+        // Bronze
+        { 157,  73,   0 }, { 165,  79,   0 }, { 173,  86,   0 }, { 181,  93,  10 }, { 198, 119,  57 },
+        // Silver
+        {  56,  84, 110 }, {  61,  90, 116 }, {  67,  95, 122 }, {  73, 105, 137 }, {  78, 106, 134 },
+        // Gold
+        { 210, 133,   0 }, { 223, 143,   0 }, { 236, 154,   0 }, { 249, 165,  24 }, { 255, 176,  40 },
+        // Platinum
+        {   0, 199, 139 }, {   0, 212, 151 }, {  39, 226, 164 }, {  62, 240, 177 }, {  81, 253, 189 },
+        // Diamond
+        {   0, 158, 229 }, {   0, 169, 240 }, {   0, 180, 252 }, {  43, 191, 255 }, {  65, 202, 255 },
+        // Ruby
+        { 254,   0,  76 }, { 234,   0,  83 }, { 245,   0,  90 }, { 255,   0,  98 }, { 255,  48, 113 }
+    };
+
+    struct escape_t { char s[20]; u8 n; };
+
+    // "\033[38;2;R;G;Bm" for every color, rendered at compile time.
+    static constexpr std::array<escape_t, 31> ansi_table = [] {
+        std::array<escape_t, 31> t { };
+#ifdef ANSI_ENABLED
+        for (i32 i = 0; i < 31; i++) {
+            auto& e = t[i];
+            auto put = [&e] (char c) { e.s[e.n++] = c; };
+            auto num = [&put] (i32 v) {
+                if (v >= 100) put('0' + v / 100);
+                if (v >= 10) put('0' + v / 10 % 10);
+                put('0' + v % 10);
+            };
+
+            for (char c : std::string_view("\033[38;2;")) put(c);
+            num(std::get<0>(color_table[i])); put(';');
+            num(std::get<1>(color_table[i])); put(';');
+            num(std::get<2>(color_table[i])); put('m');
         }
+#endif
+        return t;
+    }();
 
-        return "";
-    }
-
-    std::string path() const {
-        if (!valid()) return tier_name();
+    static constexpr u8 encode(char t, i32 l) {
+        i8 k = letter_table[(u8)t];
+        if (k < 0 || l < 1 || l > 5) return 0;
 
-        return tier_name() + "/" + long_name();
+        return k * 5 + (5 - l) + 1;
     }
 
-    std::tuple<i32, i32, i32> color() const {
-        if (!this->valid()) return { 0, 0, 0 };
-        
-        return color_table[i32(*this)];
-    }
-
-    bool operator==(const tier_t& t) const
-    { return i32(*this) == i32(t); }
-
-    bool operator!=(const tier_t& t) const
-    { return !(*this == t); }
-
-    bool operator<(const tier_t& t) const
-    {  return i32(*this) < i32(t); }
-
-    bool operator>(const tier_t& t) const
-    {  return i32(*this) > i32(t); }
+public:
+    constexpr char get_tier() const { return tier_table[code]; }
+    constexpr i32 get_level() const { return code ? 5 - (code - 1) % 5 : 0; }
+
+    constexpr bool valid() const { return code != 0; }
+
+    // "G3", or "U" when unrated.
+    constexpr std::string_view short_name() const { return short_table[code]; }
+    // "Gold 3"
+    constexpr std::string_view long_name() const { return long_table[code]; }
+    // "Gold"
+    constexpr std::string_view tier_name() const { return name_table[code ? (code - 1) / 5 + 1 : 0]; }
+    // "Gold/Gold 3", relative to the workspace root.
+    constexpr std::string_view path() const { return path_table[code]; }
+
+    constexpr std::tuple<i32, i32, i32> color() const
+    { return color_table[code]; }
+
+    // 24-bit foreground escape for this tier's color.
+    // Empty when ANSI output is disabled.
+    constexpr std::string_view ansi() const
+    { return std::string_view(ansi_table[code].s, ansi_table[code].n); }
+
+    constexpr bool operator==(const tier_t& t) const { return code == t.code; }
+    constexpr bool operator!=(const tier_t& t) const { return code != t.code; }
+    constexpr bool operator<(const tier_t& t) const { return code < t.code; }
+    constexpr bool operator>(const tier_t& t) const { return code > t.code; }
+    constexpr bool operator<=(const tier_t& t) const { return code <= t.code; }
+    constexpr bool operator>=(const tier_t& t) const { return code >= t.code; }
+
+    constexpr tier_t& operator=(const tier_t&) = default;
+    constexpr tier_t& operator=(tier_t&&) = default;
+
+    constexpr explicit operator i32() const { return code; }
+};
 
-    bool operator<=(const tier_t& t) const
-    {  return i32(*this) <= i32(t); }
+static_assert(sizeof(tier_t) == 1);
 
-    bool operator>=(const tier_t& t) const
-    {  return i32(*this) >= i32(t); }
+// A set of levels stored as a mask: bit i is set when level code i is in
+// the set, so membership is a single bit test.
+struct tier_range {
+    // Every level code, Unrated included.
+    static constexpr u32 all = 0x7FFFFFFF;
+    // Bronze 5 to Ruby 1.
+    static constexpr u32 rated = 0x7FFFFFFE;
+
+    u32 mask = all;
+    bool valid = true;
+
+    constexpr tier_range() = default;
+    constexpr tier_range(const tier_range&) = default;
+    constexpr tier_range(tier_range&&) = default;
+
+    constexpr tier_range(const tier_t& s, const tier_t& e)
+    : mask(span(s, e)), valid(s.valid() && e.valid()) { }
+    // Comma separated terms, each of them "g3", "d" (d5..d1), "b3..s1",
+    // "b..s1", "b3.." (b3..r1) or "..p2" (b5..p2). A term prefixed with
+    // '!' removes its levels; a list that starts with one removes them
+    // from every rated level, so "!p" is everything but platinum.
+    constexpr tier_range(std::string_view se)
+    : mask(0) {
+        for (bool first = true; ; first = false) {
+            auto pos = se.find(',');
+            std::string_view term = se.substr(0, pos);
+
+            bool neg = !term.empty() && term[0] == '!';
+            if (neg) term.remove_prefix(1);
+
+            u32 m = parse_term(term);
+
+            if (!m) {
+                valid = false;
+                mask = 0;
+                return;
+            }
 
-    tier_t& operator=(const tier_t& t) {
-        this->set_tier(t.tier);
-        this->set_level(t.level);
-        return *this;
-    }
+            if (!neg) mask |= m;
+            else mask = (first ? rated : mask) & ~m;
 
-    tier_t& operator=(tier_t&& t) {
-        this->set_tier(t.tier);
-        this->set_level(t.level);
-        return *this;
+            if (pos == std::string_view::npos) break;
+            se.remove_prefix(pos + 1);
+        }
     }
 
-    explicit operator i32() const {
-        if (!this->valid()) return 0;
+    constexpr bool contains(const tier_t& t) const { return mask >> t.code & 1; }
 
-        i32 k = -1;
+    constexpr tier_range& operator=(const tier_range&) = default;
+    constexpr tier_range& operator=(tier_range&&) = default;
 
-        switch (this->tier) {
-            case 'B': k = 0; break;
-            case 'S': k = 1; break;
-            case 'G': k = 2; break;
-            case 'P': k = 3; break;
-            case 'D': k = 4; break;
-            case 'R': k = 5; break;
-        }
+private:
+    // Levels s..e, or 0 when either end is invalid or the span is empty.
+    static constexpr u32 span(const tier_t& s, const tier_t& e) {
+        if (!s.valid() || !e.valid() || s > e) return 0;
 
-        return k * 5 + (5 - this->level) + 1;
+        return (~0u >> (31 - e.code)) & ~((1u << s.code) - 1);
     }
-};
-
-struct tier_range {
-    tier_t start = tier_t(0), end = tier_t(30);
-    bool valid = false;
-
-    tier_range() = default;
-    tier_range(const tier_range&) = default;
-    tier_range(tier_range&&) = default;
-
-    tier_range(const tier_t& s, const tier_t& e)
-    : start(s), end(e), valid(s.valid() && e.valid()) { }
-    tier_range(const std::string& se) {
-        auto pos = se.find("..");
-        if (pos == std::string::npos) {
-            std::string s1, s2;
-
-            if (se.size() == 1) {
-                s1 = se + "5";
-                s2 = se + "1";
-            } else s1 = s2 = se;
-
-            tier_t t1(s1), t2(s2);
-            
-            valid = t1.valid() && t2.valid();
-
-            start = t1;
-            end = t2;
-        } else {
-            std::string
-                s1 = se.substr(0, pos),
-                s2 = se.substr(pos + 2);
-
-            if (s1.size() > 2 || s2.size() > 2) {
-                valid = false;
-                return;
-            }
-            
-            if (s1.size() == 1) s1 += "5";
-            if (s2.size() == 1) s2 += "1";
 
-            tier_t t1 = tier_t(s1), t2 = tier_t(s2);
+    static constexpr u32 parse_term(std::string_view t) {
+        auto pos = t.find("..");
 
-            if (!s1.empty()) start = (i32)t1;
-            if (!s2.empty()) end = (i32)t2;
+        if (pos == std::string_view::npos) {
+            if (t.size() == 1) return span(tier_t(t[0], 5), tier_t(t[0], 1));
+            if (t.size() == 2) return span(tier_t(t), tier_t(t));
 
-            valid = start.valid() && end.valid();
+            return 0;
         }
-    }
 
-    bool contains(const tier_t& t) const {
-        if (!valid || !t.valid()) return false;
+        std::string_view
+            s1 = t.substr(0, pos),
+            s2 = t.substr(pos + 2);
 
-        return start <= t && t <= end;
-    }
+        if (s1.size() > 2 || s2.size() > 2) return 0;
 
-    tier_range& operator=(const tier_range& r) {
-        this->start = r.start;
-        this->end = r.end;
-        this->valid = r.valid;
-        return *this;
+        return span(
+            s1.empty() ? tier_t(1) : s1.size() == 1 ? tier_t(s1[0], 5) : tier_t(s1),
+            s2.empty() ? tier_t(30) : s2.size() == 1 ? tier_t(s2[0], 1) : tier_t(s2)
+        );
     }
+};
 
-    tier_range& operator=(tier_range&& r) {
-        this->start = r.start;
-        this->end = r.end;
-        this->valid = r.valid;
-        return *this;
-    }
-};
\ No newline at end of file
+static_assert(tier_range("b3..s1").mask == 0b11111111000);
+static_assert(tier_range("d").mask == tier_range(tier_t('D', 5), tier_t('D', 1)).mask);
+static_assert(tier_range("..p2").mask == tier_range(tier_t(1), tier_t('P', 2)).mask);
+static_assert(tier_range("d..").mask == tier_range(tier_t('D', 5), tier_t(30)).mask);
+static_assert(tier_range("b..s1,g3,!s").mask == (tier_range("b").mask | 1u << 13));
+static_assert(tier_range("!p").mask == (tier_range::rated & ~tier_range("p").mask));
+static_assert(!tier_range("g3,").valid && !tier_range("s1..b3").valid && !tier_range("x").valid);
+static_assert(tier_t("Gold 3").ansi().size() == 0 || tier_t("Gold 3").ansi() == "\033[38;2;236;154;0m");
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "intdef.h"
+#include "tier.h"
+
+// Solution files of one kind, summed.
+struct file_stats_t {
+    u64 files = 0;
+    // Empty files, such as the placeholders update creates.
+    u64 stubs = 0;
+    u64 lines = 0, bytes = 0;
+};
+
+// What lies under the tier folders of a workspace, read without the index.
+struct layout_t {
+    // The solution files of one problem in one folder.
+    struct entry_t {
+        i32 id;
+        u32 langs;
+        // Relative to the root.
+        std::string dir;
+        // The level dir is the folder of, or Unrated for a tier folder
+        // itself and for folders that are not a level of their tier.
+        tier_t level;
+    };
+
+    // By id, then dir.
+    std::vector<entry_t> solutions;
+    // Files that are not "<id>.<registered ext>", relative to the root.
+    // Hidden files and sample folders ("<level>/<id>/") are not looked at.
+    std::vector<std::string> bad_names;
+    // Folders that are neither a level of their tier nor a sample folder.
+    std::vector<std::string> unknown_dirs;
+    // Sample folders with no solution of their id beside them.
+    std::vector<std::string> orphan_samples;
+};
+
+// Solution inventory of a workspace: problem ids per level code.
+//
+// Directory listings are kept in <root>/.bjmgr/index together with each
+// directory's mtime, and with the size and line count of every solution
+// file keyed by its mtime and size. A scan only re-reads directories that
+// gained or lost entries since the index was written, so an unchanged
+// workspace costs a stat per directory, and stats() only reads files that
+// changed. Set BJMGR_NO_INDEX=1 to always read everything.
+class workspace {
+public:
+    // Fill ps[code] with the sorted ids of every problem with a solution in
+    // a registered language (see lang.h) under the tier folders of root, by
+    // the level named by its parent directory, and langs[code] with the
+    // lang mask of each.
+    static void scan(
+        std::vector<std::vector<i32>>& ps, std::vector<std::vector<u32>>& langs,
+        const std::filesystem::path& root
+    );
+
+    // Totals of every "<id>.<ext>" file under the tier folders of root, by
+    // level code and extension. Files are mapped and counted on a thread
+    // per core.
+    static std::vector<std::map<std::string, file_stats_t>> stats(const std::filesystem::path& root);
+
+    // Everything under the tier folders of root, for fsck. The level
+    // folders are listed on a thread per core.
+    static layout_t layout(const std::filesystem::path& root);
+};
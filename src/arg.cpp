@@ -1,192 +1,128 @@
 #include "arg.h"
 
-// common return value
-#define SUCCESS 0
-
-// return value of parse_command
-#define NOT_INIT -1
-#define OPTION_NAME_ERROR 1
-#define DQUOTE_ERROR 2
-#define UNKNOWN_OPTION 3
-#define PARAMETER_MISSING 4
-
-// return value of init_option
-#define DUPLICATED_NAME 1
-#define DUPLICATED_SHORT_NAME 2
-#define INVALID_SHORT_NAME 3
-
-// o = option, d = index
-#define SET_OPT(o, d) ((o) |= (1 << (d)))
-// o = option, d = index
-#define GET_OPT(o, d) ((o) &  (1 << (d)))
-
-static std::unordered_map<std::string, opt_t> _opts;
-static std::vector<opt_t> _short_opts(52);
-static u64 _short_opts_flag = 0;
-static bool _init = false;
-
 enum class token_t {
-    NONE, ARG, SHORT_OPT, LONG_OPT, EOO
-};
-
-static std::vector<std::string> _init_option_errstr {
-    "Unknown Error",
-    "Option name duplicated",
-    "Option short name duplicated",
-    "Invalid short name"
+    NONE, ARG, STDIN, SHORT_OPT, LONG_OPT, EOO, ERROR
 };
 
-static std::vector<std::string> _parse_command_errstr {
-    "Parser isn't have been initialized",
+static constexpr const char* _parse_command_errstr[] = {
     "Unknown Error",
     "Invalid option name",
     "Illegal Error (DQUOTE_ERROR)",
     "Unknown option name",
-    "Missing parameter"
+    "Missing parameter",
+    "'-' (stdin) is not accepted by this command"
 };
 
-template <typename T>
-inline T xclamp(T value, T range_s, T range_e, T def_value) {
-    return range_s <= value && value < range_e ? value : def_value;
+const char* parse_errstr(parse_error_t res) {
+    auto i = (std::size_t)res;
+    return _parse_command_errstr[i < std::size(_parse_command_errstr) ? i : 0];
 }
 
-std::string __err2str(void* f, i32 res) {
-    if (f == (void*)init_options)
-        return _init_option_errstr[xclamp(res, 0, (i32)_init_option_errstr.size(), 0)];
-    else if (f == (void*)parse_command)
-        return _parse_command_errstr[xclamp(res + 1, 0, (i32)_parse_command_errstr.size(), 1)];
-    else
-        return "Unknown Error (Reason : Unknown Function)";
-}
+// Classify s and strip its dashes in place.
+static token_t classify(std::string_view& s) {
+    if (s.empty()) return token_t::NONE;
+    if (s[0] != '-') return token_t::ARG;
 
-inline constexpr i32 sn2i(char c) {
-    if ('a' <= c && c <= 'z') return c - 'a';
-    if ('A' <= c && c <= 'Z') return c - 'A' + 26;
-    return -1;
-}
+    // A lone '-' conventionally names stdin.
+    if (s.size() == 1) return token_t::STDIN;
 
-i32 init_options(const std::vector<opt_t>& __opts) {
-    _opts.clear();
-    _short_opts_flag = 0;
-    
-    for (const auto& o : __opts) {
-        if (_opts.count(o.name))
-            return DUPLICATED_NAME;
-
-        _opts[o.name] = o;
+    if (s[1] != '-') {
+        s.remove_prefix(1);
+        return token_t::SHORT_OPT;
+    }
 
-        if (o.short_name != '\0') {
-            i32 d = sn2i(o.short_name);
+    if (s.size() == 2) return token_t::EOO;
+    if (s.size() == 3) return token_t::ERROR;
 
-            if (d == -1) return INVALID_SHORT_NAME;
+    s.remove_prefix(2);
+    return token_t::LONG_OPT;
+}
 
-            if (GET_OPT(_short_opts_flag, d))
-                return DUPLICATED_SHORT_NAME;
-            
-            _short_opts[d] = o;
-            SET_OPT(_short_opts_flag, d);
-        }
-    }
+static const opt_t* find_long(const opt_view& opts, std::string_view s) {
+    for (std::size_t i = 0; i < opts.size; i++)
+        if (opts.opts[i].name == s) return opts.opts + i;
 
-    _init = true;
-    return SUCCESS;
+    return nullptr;
 }
 
-i32 parse_command(const std::vector<std::string>& vs, args& ret) {
-    if (!_init) return NOT_INIT;
-
-    std::vector<std::pair<token_t, std::string>> tokens;
-
-    // Scan and tokenize
-    for (const auto& s : vs) {
-        std::string tks = strlib::trim(s);
-        if (s.empty()) continue;
-
-        if (s[0] == '-') {
-            if (s.size() == 1)
-                return OPTION_NAME_ERROR;
-            
-            if (s[1] == '-') {
-                if (s.size() == 2)
-                    tokens.emplace_back(token_t::EOO, "--");
-                else if (s.size() == 3)
-                    return OPTION_NAME_ERROR;
-                else
-                    tokens.emplace_back(token_t::LONG_OPT, s.substr(2));
-            } else {
-                tokens.emplace_back(token_t::SHORT_OPT, s.substr(1));
-            }
-        } else
-            tokens.emplace_back(token_t::ARG, s);
+parse_error_t parse_command(i32 argc, const char* const* argv, const opt_view& opts, args& ret) {
+    // A malformed token anywhere fails the whole command line, as before
+    // any of it is applied.
+    for (i32 i = 0; i < argc; i++) {
+        std::string_view s = argv[i];
+        if (classify(s) == token_t::ERROR) return parse_error_t::option_name;
     }
 
-
-    // Parse
     bool opt_flag = true;
-    for (size_t i = 0; i < tokens.size(); i++) {
-        auto [t, s] = tokens[i];
+
+    // Take the next token as the parameter of o.
+    auto param = [&] (i32& i, const opt_t& o) -> parse_error_t {
+        for (i++; i < argc && !*argv[i]; i++);
+
+        if (i == argc) return parse_error_t::parameter_missing;
+
+        std::string_view s = argv[i];
+        token_t t = classify(s);
+        if (t != token_t::ARG && t != token_t::STDIN) return parse_error_t::parameter_missing;
+
+        ret.options.set(o.name, s);
+        return parse_error_t::none;
+    };
+
+    for (i32 i = 0; i < argc; i++) {
+        std::string_view raw = argv[i], s = raw;
+        token_t t = classify(s);
+
+        if (t == token_t::NONE) continue;
 
         if (!opt_flag) {
-            switch (t) {
-                case token_t::SHORT_OPT: ret.args.push_back("-"  + s); break;
-                case token_t::LONG_OPT:  ret.args.push_back("--" + s); break;
-                case token_t::NONE: break;
-                default: ret.args.push_back(s); break;
-            }
+            ret.args.push_back(raw);
             continue;
         }
 
         switch (t) {
-            case token_t::NONE: break;
             case token_t::ARG: ret.args.push_back(s); break;
+            case token_t::STDIN:
+                if (!opts.stdin_arg) return parse_error_t::stdin_arg;
+                ret.args.push_back(s);
+                break;
             case token_t::SHORT_OPT: {
-                for (size_t j = 0; j < s.size(); j++) {
+                for (std::size_t j = 0; j < s.size(); j++) {
                     i32 d = sn2i(s[j]);
-                    if (d == -1) return OPTION_NAME_ERROR;
+                    if (d == -1) return parse_error_t::option_name;
 
-                    if (!GET_OPT(_short_opts_flag, d))
-                        return UNKNOWN_OPTION;
+                    if (opts.short_idx[d] == -1)
+                        return parse_error_t::unknown_option;
 
-                    auto& o = _short_opts[d];
+                    const opt_t& o = opts.opts[opts.short_idx[d]];
 
                     if (o.has_parameter) {
                         if (j + 1 == s.size()) {
-                            if (i + 1 == tokens.size())
-                                return PARAMETER_MISSING;
-                            
-                            if (opt_flag && tokens[i + 1].first != token_t::ARG)
-                                return PARAMETER_MISSING;
-                            
-                            ret.options[o.name] = {o.name, tokens[++i].second};
+                            if (auto r = param(i, o); r != parse_error_t::none) return r;
                             break;
                         }
-                        
-                        ret.options[o.name] = {o.name, s.substr(j + 1)};
+
+                        ret.options.set(o.name, s.substr(j + 1));
                         break;
-                    } else 
-                        ret.options[o.name] = {o.name, std::nullopt};
+                    } else
+                        ret.options.set(o.name, std::nullopt);
                 }
             } break;
             case token_t::LONG_OPT: {
-                if (!_opts.count(s))
-                    return UNKNOWN_OPTION;
-                
-                auto& o = _opts[s];
-
-                if (o.has_parameter) {
-                    if (i + 1 == tokens.size())
-                        return PARAMETER_MISSING;
-                    
-                    if (opt_flag && tokens[i + 1].first != token_t::ARG)
-                        return PARAMETER_MISSING;
-                    
-                    ret.options[o.name] = {o.name, tokens[++i].second};
+                const opt_t* o = find_long(opts, s);
+
+                if (!o)
+                    return parse_error_t::unknown_option;
+
+                if (o->has_parameter) {
+                    if (auto r = param(i, *o); r != parse_error_t::none) return r;
                 } else
-                    ret.options[o.name] = {o.name, std::nullopt};
+                    ret.options.set(o->name, std::nullopt);
             } break;
             case token_t::EOO: opt_flag = false; break;
+            default: break;
         }
     }
 
-    return SUCCESS;
-}
\ No newline at end of file
+    return parse_error_t::none;
+}
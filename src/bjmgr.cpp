@@ -0,0 +1,224 @@
+#include "bjmgr.h"
+#include "workspace.h"
+#include "lang.h"
+#include "profile.h"
+#include "metrics.h"
+
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+static failure_t io_error(std::string msg) {
+    failure_t e;
+    e.kind = failure_t::io;
+    e.message = std::move(msg);
+    return e;
+}
+
+std::vector<record_t> inventory_t::records() const {
+    std::vector<record_t> r;
+
+    for (i32 i = 1; i <= 30; i++)
+        for (auto x : levels[i]) r.emplace_back(x, tier_t(i));
+
+    std::sort(r.begin(), r.end());
+    return r;
+}
+
+result_t<inventory_t> bjmgr::scan(const fs::path& root) {
+    std::error_code ec;
+
+    if (!fs::exists(root, ec)) return io_error("'" + root.string() + "': No such directory");
+    if (!fs::is_directory(root, ec)) return io_error("'" + root.string() + "': Not a directory");
+
+    PROF_SCOPE("scan");
+    metrics_phase _mp("scan");
+
+    inventory_t inv;
+
+    try {
+        workspace::scan(inv.levels, inv.langs, root);
+    } catch (const std::exception& e) {
+        return io_error(e.what());
+    }
+
+    return inv;
+}
+
+result_t<std::vector<std::map<std::string, file_stats_t>>> bjmgr::stats(const fs::path& root) {
+    std::error_code ec;
+
+    if (!fs::exists(root, ec)) return io_error("'" + root.string() + "': No such directory");
+    if (!fs::is_directory(root, ec)) return io_error("'" + root.string() + "': Not a directory");
+
+    PROF_SCOPE("stats");
+
+    try {
+        return workspace::stats(root);
+    } catch (const std::exception& e) {
+        return io_error(e.what());
+    }
+}
+
+result_t<layout_t> bjmgr::layout(const fs::path& root) {
+    std::error_code ec;
+
+    if (!fs::exists(root, ec)) return io_error("'" + root.string() + "': No such directory");
+    if (!fs::is_directory(root, ec)) return io_error("'" + root.string() + "': Not a directory");
+
+    PROF_SCOPE("layout");
+
+    try {
+        return workspace::layout(root);
+    } catch (const std::exception& e) {
+        return io_error(e.what());
+    }
+}
+
+std::vector<move_t> bjmgr::plan_patch(const inventory_t& inv, const std::vector<problem_t>& current) {
+    PROF_SCOPE("diff");
+
+    std::unordered_map<i32, tier_t> lv;
+    lv.reserve(current.size());
+    for (auto& p : current) lv[p.id] = p.tier;
+
+    std::vector<move_t> moves;
+
+    // Same (tier, id) order as records(), keeping each problem's mask.
+    for (i32 i = 1; i <= 30; i++) {
+        for (std::size_t k = 0; k < inv.levels[i].size(); k++) {
+            i32 id = inv.levels[i][k];
+            auto it = lv.find(id);
+            tier_t t = it != lv.end() ? it->second : tier_t();
+
+            if (t != tier_t(i)) moves.push_back({ id, tier_t(i), t, inv.langs[i][k] });
+        }
+    }
+
+    return moves;
+}
+
+std::vector<applied_t> bjmgr::apply_patch(
+    const fs::path& root, const std::vector<move_t>& moves,
+    const std::function<void(const applied_t&)>& on_move
+) {
+    std::vector<applied_t> out;
+    out.reserve(moves.size());
+
+    for (auto& m : moves) {
+        applied_t a { m, applied_t::moved, "" };
+
+        if (!m.to.valid()) a.outcome = applied_t::skipped;
+        else {
+            PROF_SCOPE("rename", "fs", m.id);
+
+            fs::path
+                od = root / fs::path(m.dir.empty() ? m.from.path() : m.dir),
+                nd = root / fs::path(m.to.path());
+
+            std::error_code ec;
+            fs::create_directories(nd, ec);
+
+            // Every file of the problem moves, or none does: after a failure
+            // the files already moved go back, so the problem is never left
+            // split across two folders.
+            u32 mask = m.langs ? m.langs : lang::bit("cpp");
+            std::vector<std::string> done;
+
+            for (; mask && !ec; mask &= mask - 1) {
+                auto name = std::to_string(m.id) + "." + std::string(lang::table[__builtin_ctz(mask)].ext);
+                fs::rename(od / name, nd / name, ec);
+                if (!ec) done.push_back(std::move(name));
+            }
+
+            // The samples go along, as test and bench look for them next to
+            // the solution. An existing folder there is not merged into.
+            auto samples = std::to_string(m.id);
+            std::error_code sc;
+
+            bool moving_samples = !ec && fs::is_directory(od / samples, sc);
+
+            if (moving_samples) {
+                if (fs::exists(nd / samples, sc)) ec = std::make_error_code(std::errc::file_exists);
+                else fs::rename(od / samples, nd / samples, ec);
+            }
+
+            if (ec) {
+                a.outcome = applied_t::failed;
+                a.message = moving_samples ? "'" + (nd / samples).string() + "': " + ec.message() : ec.message();
+
+                for (auto it = done.rbegin(); it != done.rend(); ++it) {
+                    std::error_code rc;
+                    fs::rename(nd / *it, od / *it, rc);
+                    if (rc) a.message += "; '" + (nd / *it).string() + "' not moved back: " + rc.message();
+                }
+            }
+        }
+
+        if (on_move) on_move(a);
+        out.push_back(std::move(a));
+    }
+
+    return out;
+}
+
+std::vector<check_t> bjmgr::plan_update(
+    const inventory_t& inv, std::vector<problem_t> solved, const tier_range& filter
+) {
+    PROF_SCOPE("diff");
+
+    std::stable_sort(solved.begin(), solved.end(), [] (const problem_t& a, const problem_t& b) { return a.id < b.id; });
+
+    // Last page wins for a problem listed twice, as it is the newest.
+    std::vector<problem_t> uniq;
+    for (auto& p : solved) {
+        if (!uniq.empty() && uniq.back().id == p.id) uniq.back() = std::move(p);
+        else uniq.push_back(std::move(p));
+    }
+
+    std::vector<i32> have;
+    for (auto r : inv.records()) have.push_back(r.id());
+    std::sort(have.begin(), have.end());
+
+    std::vector<check_t> out;
+    out.reserve(uniq.size());
+
+    for (auto& p : uniq) {
+        bool present = std::binary_search(have.begin(), have.end(), p.id);
+        // An unrated problem has no level folder, so it is never created.
+        bool selected = !present && p.tier.valid() && filter.contains(p.tier);
+
+        out.push_back({ std::move(p), present, selected });
+    }
+
+    return out;
+}
+
+fs::path bjmgr::solution_path(const fs::path& root, i32 id, tier_t t, std::string_view ext) {
+    std::string name = std::to_string(id);
+    name += '.';
+    name += ext;
+
+    return root / t.path() / name;
+}
+
+failure_t bjmgr::create(const fs::path& p, bool overwrite) {
+    PROF_SCOPE("create", "fs");
+
+    std::error_code ec;
+    fs::create_directories(p.parent_path(), ec);
+    if (ec) return io_error("'" + p.parent_path().string() + "': " + ec.message());
+
+    // O_EXCL so a solution written since the caller looked is never lost.
+    int fd = ::open(p.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (overwrite ? O_TRUNC : O_EXCL), 0644);
+    if (fd < 0) return io_error("'" + p.string() + "': " + std::strerror(errno));
+
+    ::close(fd);
+    return { };
+}
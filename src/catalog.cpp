@@ -0,0 +1,399 @@
+#include "catalog.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+
+// File layout, native endian: header, trigram table sorted by key, tag
+// table sorted by key, the problem columns (ids ascending, solver counts,
+// n + 1 title offsets), postings, the level column and the text. Titles
+// are stored in id order, followed by the tag keys.
+struct header_t {
+    char magic[8];
+    u32 n, ntri, ntag, npost, ntext, _pad;
+};
+
+struct catalog_t::tri_rec {
+    // Three 21-bit code points.
+    u64 key;
+    // Posting list: _post[off, off + len), ascending problem indices.
+    u32 off, len;
+};
+
+struct catalog_t::tag_rec {
+    u32 key_off;
+    u16 key_len, _pad;
+    // Posting list, as for trigrams.
+    u32 off, len;
+};
+
+static_assert(sizeof(header_t) == 32 && sizeof(catalog_t::tri_rec) == 16 && sizeof(catalog_t::tag_rec) == 16);
+
+// An older catalog does not match and reads as empty, so it is rebuilt by
+// the next merge.
+static constexpr char magic[8] = { 'b', 'j', 'm', 'g', 'r', 'c', 't', '3' };
+
+// Code points of s with ASCII lowercased and whitespace runs collapsed to
+// one space. Bytes that do not start a UTF-8 sequence stand for themselves.
+static void normalize(std::string_view s, std::vector<u32>& out) {
+    out.clear();
+    bool space = true;
+
+    for (std::size_t i = 0; i < s.size(); ) {
+        u8 c = s[i];
+        u32 cp = c;
+        std::size_t len = 1;
+
+        if (c >= 0xC0 && c < 0xE0 && i + 1 < s.size()) { cp = c & 0x1F; len = 2; }
+        else if (c >= 0xE0 && c < 0xF0 && i + 2 < s.size()) { cp = c & 0x0F; len = 3; }
+        else if (c >= 0xF0 && c < 0xF8 && i + 3 < s.size()) { cp = c & 0x07; len = 4; }
+
+        for (std::size_t k = 1; k < len; k++) cp = cp << 6 | (s[i + k] & 0x3F);
+        i += len;
+
+        if (cp == ' ' || cp == '\t' || cp == '\n' || cp == '\r' || cp == 0x3000) {
+            if (!space) out.push_back(' ');
+            space = true;
+            continue;
+        }
+
+        if (cp >= 'A' && cp <= 'Z') cp |= 0x20;
+
+        out.push_back(cp);
+        space = false;
+    }
+
+    if (!out.empty() && out.back() == ' ') out.pop_back();
+}
+
+static u64 tri_key(const u32* p) { return (u64)p[0] << 42 | (u64)p[1] << 21 | p[2]; }
+
+// Distinct trigram keys of cps, sorted.
+static void trigrams(const std::vector<u32>& cps, std::vector<u64>& out) {
+    out.clear();
+    for (std::size_t i = 0; i + 3 <= cps.size(); i++) out.push_back(tri_key(&cps[i]));
+
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+fs::path catalog_t::default_path() {
+    if (const char* e = std::getenv("BJMGR_CATALOG"); e && *e) return e;
+    if (const char* e = std::getenv("XDG_CACHE_HOME"); e && *e) return fs::path(e) / "bjmgr" / "catalog";
+    if (const char* e = std::getenv("HOME"); e && *e) return fs::path(e) / ".cache" / "bjmgr" / "catalog";
+
+    return fs::temp_directory_path() / ("bjmgr-catalog-" + std::to_string(getuid()));
+}
+
+catalog_t::catalog_t(const fs::path& __path) {
+    int fd = ::open(__path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+
+    struct stat st;
+
+    if (!fstat(fd, &st) && st.st_size >= (off_t)sizeof(header_t)) {
+        void* m = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (m != MAP_FAILED) { _map = m; _len = st.st_size; }
+    }
+
+    ::close(fd);
+
+    if (!_map) return;
+
+    const header_t* h = (const header_t*)_map;
+    const char* p = (const char*)_map + sizeof(header_t);
+
+    bool ok = !std::memcmp(h->magic, magic, sizeof(magic)) &&
+        _len == sizeof(header_t) + (u64)h->ntri * sizeof(tri_rec) + (u64)h->ntag * sizeof(tag_rec) +
+                (u64)h->n * 3 * sizeof(u32) + sizeof(u32) + (u64)h->npost * sizeof(u32) + h->n + h->ntext;
+
+    if (ok) {
+        _tris = (const tri_rec*)p; p += (u64)h->ntri * sizeof(tri_rec);
+        _tags = (const tag_rec*)p; p += (u64)h->ntag * sizeof(tag_rec);
+        _ids = (const i32*)p; p += (u64)h->n * sizeof(i32);
+        _solvers = (const u32*)p; p += (u64)h->n * sizeof(u32);
+        _title_off = (const u32*)p; p += ((u64)h->n + 1) * sizeof(u32);
+        _post = (const u32*)p; p += (u64)h->npost * sizeof(u32);
+        _levels = (const u8*)p; p += h->n;
+        _text = p;
+
+        // Cheap enough to check every range once, so lookups need not.
+        for (u32 i = 0; ok && i < h->ntri; i++) ok = (u64)_tris[i].off + _tris[i].len <= h->npost;
+        for (u32 i = 0; ok && i < h->ntag; i++)
+            ok = (u64)_tags[i].off + _tags[i].len <= h->npost && (u64)_tags[i].key_off + _tags[i].key_len <= h->ntext;
+        for (u32 i = 0; ok && i < h->n; i++) ok = _title_off[i] <= _title_off[i + 1] && _levels[i] <= 30;
+        ok = ok && _title_off[h->n] <= h->ntext;
+    }
+
+    if (!ok) {
+        munmap(_map, _len);
+        _map = nullptr;
+        _len = 0;
+        return;
+    }
+
+    _n = h->n;
+    _ntri = h->ntri;
+    _ntag = h->ntag;
+}
+
+catalog_t::~catalog_t() {
+    if (_map) munmap(_map, _len);
+}
+
+catalog_t::entry_t catalog_t::at(u32 i) const {
+    return {
+        _ids[i], tier_t((i32)_levels[i]), _solvers[i],
+        std::string_view(_text + _title_off[i], _title_off[i + 1] - _title_off[i])
+    };
+}
+
+i32 catalog_t::find(i32 id) const {
+    auto it = std::lower_bound(_ids, _ids + _n, id);
+    return it != _ids + _n && *it == id ? (i32)(it - _ids) : -1;
+}
+
+std::string_view catalog_t::tag(u32 t) const {
+    return std::string_view(_text + _tags[t].key_off, _tags[t].key_len);
+}
+
+catalog_t::list_t catalog_t::tagged(u32 t) const {
+    return { _post + _tags[t].off, _post + _tags[t].off + _tags[t].len };
+}
+
+i32 catalog_t::find_tag(std::string_view key) const {
+    u32 lo = 0, hi = _ntag;
+
+    while (lo < hi) {
+        u32 mid = (lo + hi) / 2;
+        if (tag(mid) < key) lo = mid + 1;
+        else hi = mid;
+    }
+
+    return lo < _ntag && tag(lo) == key ? (i32)lo : -1;
+}
+
+std::vector<u32> catalog_t::search(std::string_view text) const {
+    std::vector<u32> q, t, out;
+    normalize(text, q);
+
+    auto contains = [&] (u32 i) {
+        normalize(at(i).title, t);
+        return std::search(t.begin(), t.end(), q.begin(), q.end()) != t.end();
+    };
+
+    // Too short for a trigram: scan the titles.
+    if (q.size() < 3) {
+        for (u32 i = 0; i < _n; i++) if (contains(i)) out.push_back(i);
+        return out;
+    }
+
+    std::vector<u64> keys;
+    trigrams(q, keys);
+
+    std::vector<const tri_rec*> lists;
+
+    for (u64 k : keys) {
+        auto it = std::lower_bound(_tris, _tris + _ntri, k, [] (const tri_rec& r, u64 k) { return r.key < k; });
+        if (it == _tris + _ntri || it->key != k) return out;
+
+        lists.push_back(it);
+    }
+
+    // Start from the rarest trigram and binary search the longer lists, so
+    // the cost follows the smallest list rather than the largest.
+    std::sort(lists.begin(), lists.end(), [] (const tri_rec* a, const tri_rec* b) { return a->len < b->len; });
+
+    out.assign(_post + lists[0]->off, _post + lists[0]->off + lists[0]->len);
+
+    for (std::size_t l = 1; l < lists.size() && !out.empty(); l++) {
+        const u32* b = _post + lists[l]->off;
+        const u32* e = b + lists[l]->len;
+        std::size_t k = 0;
+
+        for (u32 x : out) {
+            b = std::lower_bound(b, e, x);
+            if (b == e) break;
+            if (*b == x) out[k++] = x;
+        }
+
+        out.resize(k);
+    }
+
+    out.erase(std::remove_if(out.begin(), out.end(), [&] (u32 i) { return i >= _n; }), out.end());
+
+    // A single trigram query is matched exactly by its posting list. Longer
+    // ones only guarantee every trigram occurs somewhere in the title.
+    if (q.size() > 3)
+        out.erase(std::remove_if(out.begin(), out.end(), [&] (u32 i) { return !contains(i); }), out.end());
+
+    return out;
+}
+
+namespace {
+
+struct row_t {
+    i32 id;
+    u8 level;
+    u32 solvers;
+    std::string title;
+    std::vector<std::string> tags;
+};
+
+}
+
+static bool write_catalog(const fs::path& path, const std::vector<row_t>& rows) {
+    std::string text;
+    std::vector<i32> ids;
+    std::vector<u32> solvers, title_off;
+    std::vector<u8> levels;
+    std::vector<std::pair<u64, u32>> pairs;
+    std::vector<u32> cps;
+    std::vector<u64> keys;
+
+    for (u32 i = 0; i < (u32)rows.size(); i++) {
+        auto& r = rows[i];
+
+        ids.push_back(r.id);
+        solvers.push_back(r.solvers);
+        levels.push_back(r.level);
+        title_off.push_back(text.size());
+        text += r.title;
+
+        normalize(r.title, cps);
+        trigrams(cps, keys);
+
+        for (u64 k : keys) pairs.emplace_back(k, i);
+    }
+
+    title_off.push_back(text.size());
+
+    // Sorted by key and then index, so every posting list comes out sorted.
+    std::sort(pairs.begin(), pairs.end());
+
+    std::vector<catalog_t::tri_rec> tris;
+    std::vector<u32> post;
+    post.reserve(pairs.size());
+
+    for (std::size_t i = 0; i < pairs.size(); ) {
+        std::size_t j = i;
+        while (j < pairs.size() && pairs[j].first == pairs[i].first) post.push_back(pairs[j++].second);
+
+        tris.push_back({ pairs[i].first, (u32)i, (u32)(j - i) });
+        i = j;
+    }
+
+    // Rows are visited in index order, so these lists come out sorted too.
+    std::map<std::string_view, std::vector<u32>> by_tag;
+
+    for (u32 i = 0; i < (u32)rows.size(); i++)
+        for (auto& t : rows[i].tags) by_tag[t].push_back(i);
+
+    std::vector<catalog_t::tag_rec> tags;
+
+    for (auto& [key, ids] : by_tag) {
+        u16 len = (u16)std::min<std::size_t>(key.size(), 0xFFFF);
+
+        tags.push_back({ (u32)text.size(), len, 0, (u32)post.size(), (u32)ids.size() });
+        text.append(key, 0, len);
+        post.insert(post.end(), ids.begin(), ids.end());
+    }
+
+    header_t h;
+    std::memcpy(h.magic, magic, sizeof(magic));
+    h.n = ids.size();
+    h.ntri = tris.size();
+    h.ntag = tags.size();
+    h.npost = post.size();
+    h.ntext = text.size();
+    h._pad = 0;
+
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+
+    fs::path tmp = path;
+    tmp += ".tmp." + std::to_string(getpid());
+
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+
+    bool ok =
+        std::fwrite(&h, sizeof(h), 1, f) == 1 &&
+        std::fwrite(tris.data(), sizeof(tris[0]), tris.size(), f) == tris.size() &&
+        std::fwrite(tags.data(), sizeof(tags[0]), tags.size(), f) == tags.size() &&
+        std::fwrite(ids.data(), sizeof(i32), ids.size(), f) == ids.size() &&
+        std::fwrite(solvers.data(), sizeof(u32), solvers.size(), f) == solvers.size() &&
+        std::fwrite(title_off.data(), sizeof(u32), title_off.size(), f) == title_off.size() &&
+        std::fwrite(post.data(), sizeof(u32), post.size(), f) == post.size() &&
+        std::fwrite(levels.data(), 1, levels.size(), f) == levels.size() &&
+        std::fwrite(text.data(), 1, text.size(), f) == text.size();
+    ok = std::fclose(f) == 0 && ok;
+
+    if (ok) fs::rename(tmp, path, ec);
+    if (!ok || ec) fs::remove(tmp, ec);
+
+    return ok && !ec;
+}
+
+bool catalog_t::merge(const fs::path& path, const std::vector<problem_t>& ps) {
+    std::vector<row_t> rows, add;
+
+    {
+        catalog_t c(path);
+        rows.reserve(c.size() + ps.size());
+
+        for (u32 i = 0; i < c.size(); i++) {
+            auto e = c.at(i);
+            rows.push_back({ e.id, e.tier.code, e.solvers, std::string(e.title), { } });
+        }
+
+        for (u32 t = 0; t < c.tag_count(); t++)
+            for (u32 i : c.tagged(t)) rows[i].tags.emplace_back(c.tag(t));
+    }
+
+    auto by_id = [] (const row_t& a, const row_t& b) { return a.id < b.id; };
+
+    // Solver counts grow all the time and only rank 'next' suggestions, so
+    // a drift below 1/8 does not warrant rewriting the file.
+    auto drifted = [] (u32 a, u32 b) { return (a > b ? a - b : b - a) > std::max(a, b) / 8; };
+
+    for (auto& p : ps) {
+        if (p.name.empty()) continue;
+
+        row_t r { p.id, p.tier.code, p.solvers, p.name, p.tags };
+        std::sort(r.tags.begin(), r.tags.end());
+        r.tags.erase(std::unique(r.tags.begin(), r.tags.end()), r.tags.end());
+
+        auto it = std::lower_bound(rows.begin(), rows.end(), r, by_id);
+
+        if (it == rows.end() || it->id != p.id) add.push_back(std::move(r));
+        else if (it->level != r.level || it->title != r.title || it->tags != r.tags || drifted(it->solvers, r.solvers))
+            add.push_back(std::move(r));
+    }
+
+    if (add.empty()) return true;
+
+    // New rows go after the old ones, and the last row of an id wins.
+    rows.insert(rows.end(), std::make_move_iterator(add.begin()), std::make_move_iterator(add.end()));
+    std::stable_sort(rows.begin(), rows.end(), by_id);
+
+    std::vector<row_t> uniq;
+    uniq.reserve(rows.size());
+
+    for (auto& r : rows) {
+        if (!uniq.empty() && uniq.back().id == r.id) uniq.back() = std::move(r);
+        else uniq.push_back(std::move(r));
+    }
+
+    return write_catalog(path, uniq);
+}
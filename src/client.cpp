@@ -0,0 +1,393 @@
+#include "bjmgr.h"
+#include "profile.h"
+#include "metrics.h"
+#include "strlib.h"
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <unordered_map>
+#include <algorithm>
+#include <ctime>
+#include <cstdlib>
+
+#include <curl/curl.h>
+#include <nlohmann/json.hpp>
+
+#define API_VERSION "v3"
+#define BASE_URL "https://solved.ac/api/" API_VERSION "/"
+
+using nlohmann::json;
+
+// Problems per problem/lookup request and per search page.
+static constexpr std::size_t lookup_batch = 100, search_page = 50;
+
+// Entries expire so that level changes still show up in a long-lived client.
+static constexpr std::time_t problem_ttl = 600;
+
+struct client_t::worker {
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<std::function<void(worker&)>> jobs;
+    bool stop = false;
+    std::thread th;
+
+    // client_t::problem() requests not yet sent, and whether a job to
+    // send them is queued.
+    std::vector<std::pair<i32, callback_t<problem_t>>> pending;
+    bool flushing = false;
+
+    // Touched by the worker thread only.
+    CURL* curl = nullptr;
+    std::string buf;
+    std::unordered_map<i32, std::pair<std::time_t, problem_t>> problems;
+
+    void run();
+
+    // Cached problem, or nullptr if absent or expired.
+    const problem_t* cached(i32 id);
+
+    // Answer everything in pending with as few lookups as possible.
+    void flush(const std::string& api_url);
+
+    // GET url into buf. On success the body is parsed into out.
+    failure_t get(const std::string& url, json& out);
+};
+
+static size_t write_callback(void* contents, size_t size, size_t nmemb, void* userp) {
+    ((std::string*)userp)->append((char*)contents, size * nmemb);
+    return size * nmemb;
+}
+
+void client_t::worker::run() {
+    for (;;) {
+        std::function<void(worker&)> job;
+
+        {
+            std::unique_lock<std::mutex> lk(mtx);
+            cv.wait(lk, [&] { return stop || !jobs.empty(); });
+
+            if (jobs.empty()) break;
+
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        job(*this);
+    }
+
+    if (curl) curl_easy_cleanup(curl);
+}
+
+failure_t client_t::worker::get(const std::string& url, json& out) {
+    failure_t e;
+
+    // Set up on first use, so a client that is never asked anything never
+    // initializes curl or its TLS backend.
+    static const bool global = curl_global_init(CURL_GLOBAL_DEFAULT) == CURLE_OK;
+
+    if (!curl && global) curl = curl_easy_init();
+    if (!curl) {
+        e.kind = failure_t::network;
+        e.message = "Error while initializing CURL";
+        return e;
+    }
+
+    // Reset rather than recreate, to keep the connection alive.
+    curl_easy_reset(curl);
+    buf.clear();
+
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &buf);
+
+    CURLcode req;
+    {
+        PROF_SCOPE("http", "net");
+        req = curl_easy_perform(curl);
+    }
+
+    if (req != CURLE_OK) {
+        e.kind = failure_t::network;
+        e.message = curl_easy_strerror(req);
+        return e;
+    }
+
+    long sc = 0; curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &sc);
+
+    if (metrics::enabled()) {
+        double tt = 0; curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME, &tt);
+        curl_off_t dl = 0; curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &dl);
+
+        metrics::http(tt, sc, dl);
+    }
+
+    if (sc != 200) {
+        curl_off_t rt = 0; curl_easy_getinfo(curl, CURLINFO_RETRY_AFTER, &rt);
+
+        e.kind = failure_t::http;
+        e.status = sc;
+        e.retry_after = rt;
+        e.message = "HTTP Status Code : " + std::to_string(sc);
+        e.body = buf;
+        return e;
+    }
+
+    try {
+        PROF_SCOPE("parse");
+        out = json::parse(buf);
+    } catch (const std::exception& x) {
+        e.kind = failure_t::parse;
+        e.message = x.what();
+        e.body = buf;
+    }
+
+    return e;
+}
+
+const problem_t* client_t::worker::cached(i32 id) {
+    auto it = problems.find(id);
+    if (it == problems.end()) return nullptr;
+
+    if (std::time(nullptr) - it->second.first < problem_ttl) return &it->second.second;
+
+    problems.erase(it);
+    return nullptr;
+}
+
+static failure_t parse_error(const std::exception& x) {
+    failure_t e;
+    e.kind = failure_t::parse;
+    e.message = x.what();
+    return e;
+}
+
+static problem_t to_problem(const json& it) {
+    problem_t p;
+
+    p.id = it.at("problemId").get<i32>();
+    p.tier = tier_t(it.at("level").get<i32>());
+    p.name = it.value("titleKo", "");
+    p.solvers = it.value("acceptedUserCount", 0u);
+    p.url = "https://www.acmicpc.net/problem/" + std::to_string(p.id);
+
+    if (auto t = it.find("tags"); t != it.end())
+        for (auto& x : *t) p.tags.push_back(x.at("key").get<std::string>());
+
+    return p;
+}
+
+// Future form of a callback-form call.
+template <typename T, typename F>
+static std::future<result_t<T>> as_future(F&& call) {
+    auto pr = std::make_shared<std::promise<result_t<T>>>();
+    auto f = pr->get_future();
+
+    call([pr] (result_t<T> r) { pr->set_value(std::move(r)); });
+
+    return f;
+}
+
+std::string client_t::default_api_url() {
+    const char* e = std::getenv("BJMGR_API_URL");
+    return e && *e ? e : BASE_URL;
+}
+
+client_t::client_t(std::string __api_url)
+: _api_url(std::move(__api_url)), _worker(std::make_unique<worker>()) { }
+
+client_t::~client_t() {
+    {
+        std::lock_guard<std::mutex> lk(_worker->mtx);
+        _worker->stop = true;
+    }
+
+    _worker->cv.notify_one();
+    if (_worker->th.joinable()) _worker->th.join();
+}
+
+void client_t::submit(std::function<void(worker&)> job) {
+    {
+        std::lock_guard<std::mutex> lk(_worker->mtx);
+
+        // Started lazily, like the connection itself.
+        if (!_worker->th.joinable()) _worker->th = std::thread(&worker::run, _worker.get());
+
+        _worker->jobs.push_back(std::move(job));
+    }
+
+    _worker->cv.notify_one();
+}
+
+void client_t::worker::flush(const std::string& api_url) {
+    std::vector<std::pair<i32, callback_t<problem_t>>> reqs;
+
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        reqs.swap(pending);
+        flushing = false;
+    }
+
+    std::vector<i32> ids;
+
+    for (auto& [id, done] : reqs)
+        if (!cached(id)) ids.push_back(id);
+
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    // Ids of a failed batch, with the reason.
+    std::unordered_map<i32, failure_t> failed;
+    std::string url;
+
+    for (std::size_t i = 0; i < ids.size(); i += lookup_batch) {
+        auto b = ids.begin() + i, e = ids.begin() + std::min(i + lookup_batch, ids.size());
+
+        url.assign(api_url);
+        url += "problem/lookup?problemIds=";
+        strlib::append_join(url, b, e, ",");
+
+        json res;
+        failure_t err = get(url, res);
+
+        if (!err) {
+            try {
+                for (auto& it : res) {
+                    problem_t p = to_problem(it);
+                    problems[p.id] = { std::time(nullptr), std::move(p) };
+                }
+            } catch (const std::exception& x) {
+                err = parse_error(x);
+            }
+        }
+
+        if (err)
+            for (auto it = b; it != e; ++it) failed[*it] = err;
+    }
+
+    for (auto& [id, done] : reqs) {
+        if (auto p = cached(id)) { done(*p); continue; }
+
+        if (auto it = failed.find(id); it != failed.end()) { done(it->second); continue; }
+
+        // lookup leaves out ids it does not know.
+        failure_t e;
+        e.kind = failure_t::http;
+        e.status = 404;
+        e.message = "Problem " + std::to_string(id) + " not found";
+        done(e);
+    }
+}
+
+void client_t::problem(i32 id, callback_t<problem_t> done) {
+    bool queue;
+
+    {
+        std::lock_guard<std::mutex> lk(_worker->mtx);
+        _worker->pending.emplace_back(id, std::move(done));
+
+        queue = !_worker->flushing;
+        _worker->flushing = true;
+    }
+
+    // Everything requested before the worker gets to this job goes out
+    // with it.
+    if (queue) submit([this] (worker& w) { w.flush(_api_url); });
+}
+
+std::future<result_t<problem_t>> client_t::problem(i32 id) {
+    return as_future<problem_t>([&] (auto cb) { problem(id, std::move(cb)); });
+}
+
+void client_t::show(i32 id, callback_t<problem_t> done) {
+    submit([this, id, done = std::move(done)] (worker& w) {
+        if (auto p = w.cached(id)) return done(*p);
+
+        json res;
+        if (auto e = w.get(_api_url + "problem/show?problemId=" + std::to_string(id), res)) return done(e);
+
+        try {
+            problem_t p = to_problem(res);
+            w.problems[id] = { std::time(nullptr), p };
+            done(std::move(p));
+        } catch (const std::exception& x) {
+            done(parse_error(x));
+        }
+    });
+}
+
+std::future<result_t<problem_t>> client_t::show(i32 id) {
+    return as_future<problem_t>([&] (auto cb) { show(id, std::move(cb)); });
+}
+
+void client_t::lookup(std::vector<i32> ids, batch_t on_batch, callback_t<std::vector<problem_t>> done) {
+    submit([this, ids = std::move(ids), on_batch = std::move(on_batch), done = std::move(done)] (worker& w) {
+        std::vector<problem_t> all;
+        std::string url;
+
+        for (std::size_t i = 0; i < ids.size(); i += lookup_batch) {
+            url.assign(_api_url);
+            url += "problem/lookup?problemIds=";
+            strlib::append_join(url, ids.begin() + i, ids.begin() + std::min(i + lookup_batch, ids.size()), ",");
+
+            json res;
+            if (auto e = w.get(url, res)) return done(e);
+
+            std::vector<problem_t> batch;
+
+            try {
+                for (auto& it : res) batch.push_back(to_problem(it));
+            } catch (const std::exception& x) {
+                return done(parse_error(x));
+            }
+
+            if (on_batch) on_batch(batch, ids.size());
+            all.insert(all.end(), std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+        }
+
+        done(std::move(all));
+    });
+}
+
+std::future<result_t<std::vector<problem_t>>> client_t::lookup(std::vector<i32> ids, batch_t on_batch) {
+    return as_future<std::vector<problem_t>>([&] (auto cb) { lookup(std::move(ids), std::move(on_batch), std::move(cb)); });
+}
+
+void client_t::solved(std::string user, batch_t on_batch, callback_t<std::vector<problem_t>> done) {
+    submit([this, user = std::move(user), on_batch = std::move(on_batch), done = std::move(done)] (worker& w) {
+        const std::string url = _api_url + "search/problem?query=s@" + user;
+        std::vector<problem_t> all;
+
+        // The first page comes with the total count, so it is not fetched twice.
+        json res;
+        if (auto e = w.get(url, res)) return done(e);
+
+        std::size_t total = 0;
+
+        for (std::size_t page = 1; ; page++) {
+            std::vector<problem_t> batch;
+
+            try {
+                if (page == 1) total = res.at("count").get<std::size_t>();
+                for (auto& it : res.at("items")) batch.push_back(to_problem(it));
+            } catch (const std::exception& x) {
+                return done(parse_error(x));
+            }
+
+            if (on_batch) on_batch(batch, total);
+            all.insert(all.end(), std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+
+            if (page * search_page >= total || batch.empty()) break;
+
+            if (auto e = w.get(url + "&page=" + std::to_string(page + 1), res)) return done(e);
+        }
+
+        done(std::move(all));
+    });
+}
+
+std::future<result_t<std::vector<problem_t>>> client_t::solved(std::string user, batch_t on_batch) {
+    return as_future<std::vector<problem_t>>([&] (auto cb) { solved(std::move(user), std::move(on_batch), std::move(cb)); });
+}
@@ -0,0 +1,161 @@
+#include "history.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+
+// Block layout, native endian: header, ids_len bytes of LEB128 id deltas
+// (the first against 0), count old levels, count new levels.
+struct block_t {
+    char magic[4];
+    u32 count;
+    i64 ts;
+    u32 ids_len, _pad;
+};
+
+static_assert(sizeof(block_t) == 24);
+
+static constexpr char magic[4] = { 'b', 'j', 'h', '1' };
+
+static std::size_t block_size(const block_t& b) { return sizeof(block_t) + b.ids_len + 2 * (std::size_t)b.count; }
+
+// Length of the complete blocks at the start of p.
+static std::size_t valid_prefix(const u8* p, std::size_t len) {
+    std::size_t off = 0;
+
+    while (len - off >= sizeof(block_t)) {
+        block_t b;
+        std::memcpy(&b, p + off, sizeof(b));
+
+        if (std::memcmp(b.magic, magic, sizeof(magic)) || block_size(b) > len - off) break;
+        off += block_size(b);
+    }
+
+    return off;
+}
+
+fs::path history_t::path_for(const fs::path& root) {
+    return root / ".bjmgr" / "history";
+}
+
+history_t::history_t(const fs::path& __path) {
+    int fd = ::open(__path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+
+    struct stat st;
+
+    if (!fstat(fd, &st) && st.st_size > 0) {
+        void* m = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (m != MAP_FAILED) {
+            _map = (const u8*)m;
+            _len = st.st_size;
+            _valid = valid_prefix(_map, _len);
+        }
+    }
+
+    ::close(fd);
+}
+
+history_t::~history_t() {
+    if (_map) munmap((void*)_map, _len);
+}
+
+std::vector<history_t::change_t> history_t::range(i64 from, i64 to, const std::vector<i32>& ids) const {
+    std::vector<change_t> out;
+
+    for (std::size_t off = 0; off < _valid; ) {
+        block_t b;
+        std::memcpy(&b, _map + off, sizeof(b));
+
+        const u8* p = _map + off + sizeof(b);
+        off += block_size(b);
+
+        // Runs are appended in time order, but a clock change may break it,
+        // so every header is looked at.
+        if (b.ts < from || b.ts >= to) continue;
+
+        const u8* e = p + b.ids_len;
+        const u8* lv = e;
+        i32 id = 0;
+
+        for (u32 i = 0; i < b.count && p < e; i++) {
+            u32 d = 0;
+
+            for (u32 sh = 0; p < e && sh < 35; sh += 7) {
+                u8 c = *p++;
+                d |= (u32)(c & 0x7F) << sh;
+                if (!(c & 0x80)) break;
+            }
+
+            id += (i32)d;
+
+            if (!ids.empty() && !std::binary_search(ids.begin(), ids.end(), id)) continue;
+
+            out.push_back({ b.ts, id, tier_t((i32)lv[i]), tier_t((i32)lv[b.count + i]) });
+        }
+    }
+
+    std::stable_sort(out.begin(), out.end(), [] (const change_t& a, const change_t& b) { return a.ts < b.ts; });
+    return out;
+}
+
+bool history_t::append(const fs::path& path, i64 ts, std::vector<move_t> moves) {
+    if (moves.empty()) return true;
+
+    std::sort(moves.begin(), moves.end(), [] (const move_t& a, const move_t& b) { return a.id < b.id; });
+
+    std::string ids, from, to;
+    i32 prev = 0;
+
+    for (auto& m : moves) {
+        u32 d = (u32)(m.id - prev);
+        prev = m.id;
+
+        for (; d >= 0x80; d >>= 7) ids += (char)(d | 0x80);
+        ids += (char)d;
+
+        from += (char)m.from.code;
+        to += (char)m.to.code;
+    }
+
+    block_t b;
+    std::memcpy(b.magic, magic, sizeof(magic));
+    b.count = moves.size();
+    b.ts = ts;
+    b.ids_len = ids.size();
+    b._pad = 0;
+
+    std::string buf((const char*)&b, sizeof(b));
+    buf += ids;
+    buf += from;
+    buf += to;
+
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+
+    // Drop a torn tail, so the new block starts where a reader expects one.
+    std::size_t valid = 0;
+    struct stat st;
+
+    if (!fstat(fd, &st) && st.st_size > 0) {
+        std::string old(st.st_size, '\0');
+
+        if (pread(fd, old.data(), old.size(), 0) == (ssize_t)old.size())
+            valid = valid_prefix((const u8*)old.data(), old.size());
+    }
+
+    bool ok = (st.st_size == (off_t)valid || ftruncate(fd, valid) == 0) &&
+        pwrite(fd, buf.data(), buf.size(), valid) == (ssize_t)buf.size();
+
+    return ::close(fd) == 0 && ok;
+}
@@ -1,12 +1,25 @@
 #include "ioutil.h"
+#include "output.h"
+
+#include <cerrno>
+
+#include <unistd.h>
+
+static int _in_fd = STDIN_FILENO;
+
+void set_input_fd(int fd) { _in_fd = fd; }
+int input_fd() { return _in_fd; }
 
 int getch(bool echo) {
-    int ch;
+    unsigned char ch;
+
+    // Whatever prompt is pending has to be on screen before we block.
+    bout.flush();
     
     struct termios orig;
     struct termios crnt;
     
-    tcgetattr(0, &orig);
+    bool tty = tcgetattr(_in_fd, &orig) == 0;
     
     crnt = orig;
     
@@ -15,9 +28,12 @@ int getch(bool echo) {
     if (echo) crnt.c_lflag |=  ECHO;
     else      crnt.c_lflag &= ~ECHO;
     
-    tcsetattr(0, TCSANOW, &crnt);
-    ch = getchar();
-    tcsetattr(0, TCSANOW, &orig);
+    if (tty) tcsetattr(_in_fd, TCSANOW, &crnt);
+
+    ssize_t r;
+    while ((r = ::read(_in_fd, &ch, 1)) < 0 && errno == EINTR);
+
+    if (tty) tcsetattr(_in_fd, TCSANOW, &orig);
     
-    return ch;
-}
\ No newline at end of file
+    return r == 1 ? ch : EOF;
+}
@@ -0,0 +1,720 @@
+#include "judge.h"
+#include "lang.h"
+#include "profile.h"
+#include "strlib.h"
+
+#include <string_view>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <charconv>
+#include <fstream>
+#include <sstream>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+extern char** environ;
+
+namespace fs = std::filesystem;
+using clock_type = std::chrono::steady_clock;
+
+// BOJ's C++17 flags, less -static, which only slows linking down here.
+static constexpr const char* default_flags[] = { "-O2", "-std=gnu++17", "-DONLINE_JUDGE", "-DBOJ" };
+
+// Compiles are not timed out in practice; this only stops a stuck one.
+static constexpr i64 compile_timeout_ms = 300000;
+
+// Output beyond this is not judged; the run is stopped.
+static constexpr std::size_t output_cap = 64 << 20;
+
+struct exec_t {
+    // waitpid status, or -1 if the program could not be started.
+    int status = -1;
+    bool timed_out = false, truncated = false;
+    i64 ms = 0;
+    std::string out;
+};
+
+// Run argv with stdin from in (or /dev/null) and collect its stdout, and
+// its stderr too if merge_err. The child is killed at the deadline or the
+// output cap. Every descriptor here is close-on-exec, so children started
+// by other threads at the same time do not hold each other's pipes open.
+static exec_t spawn(const std::vector<std::string>& argv, const char* in, bool merge_err, i64 timeout_ms) {
+    exec_t r;
+    int fd[2];
+
+    if (pipe2(fd, O_CLOEXEC)) return r;
+
+    posix_spawn_file_actions_t fa;
+    posix_spawn_file_actions_init(&fa);
+    posix_spawn_file_actions_addopen(&fa, 0, in ? in : "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_adddup2(&fa, fd[1], 1);
+
+    if (merge_err) posix_spawn_file_actions_adddup2(&fa, fd[1], 2);
+    else posix_spawn_file_actions_addopen(&fa, 2, "/dev/null", O_WRONLY, 0);
+
+    std::vector<char*> av;
+    for (auto& a : argv) av.push_back(const_cast<char*>(a.c_str()));
+    av.push_back(nullptr);
+
+    auto start = clock_type::now();
+    auto deadline = start + std::chrono::milliseconds(timeout_ms);
+
+    pid_t pid;
+    int e = posix_spawnp(&pid, av[0], &fa, nullptr, av.data(), environ);
+
+    posix_spawn_file_actions_destroy(&fa);
+    ::close(fd[1]);
+
+    if (e) { ::close(fd[0]); return r; }
+
+    auto left = [&] { return std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock_type::now()).count(); };
+
+    char buf[1 << 16];
+
+    for (;;) {
+        i64 l = left();
+        if (l <= 0) { r.timed_out = true; break; }
+
+        pollfd p { fd[0], POLLIN, 0 };
+        int n = poll(&p, 1, (int)std::min<i64>(l, INT_MAX));
+        if (n <= 0) continue;
+
+        ssize_t k = ::read(fd[0], buf, sizeof(buf));
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) break;
+
+        r.out.append(buf, k);
+        if (r.out.size() > output_cap) { r.truncated = true; break; }
+    }
+
+    ::close(fd[0]);
+
+    // A program may close its output and keep running, so the deadline
+    // still holds after EOF.
+    for (int w; !r.timed_out && !r.truncated; ) {
+        if ((w = waitpid(pid, &r.status, WNOHANG)) == pid) break;
+        if (w < 0 && errno != EINTR) break;
+
+        if (left() <= 0) r.timed_out = true;
+        else std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    if (r.timed_out || r.truncated) {
+        kill(pid, SIGKILL);
+        while (waitpid(pid, &r.status, 0) < 0 && errno == EINTR) { }
+    }
+
+    r.ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock_type::now() - start).count();
+    return r;
+}
+
+static bool exited_ok(const exec_t& r) { return r.status >= 0 && WIFEXITED(r.status) && !WEXITSTATUS(r.status); }
+
+// FNV-1a, continued from h.
+static u64 fnv(u64 h, std::string_view s) {
+    for (unsigned char c : s) { h ^= c; h *= 0x100000001b3ull; }
+    return h;
+}
+
+static std::string hex(u64 h) {
+    char buf[17];
+    std::snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)h);
+    return buf;
+}
+
+template <typename T>
+static bool parse_num(std::string_view s, T& v) {
+    auto r = std::from_chars(s.data(), s.data() + s.size(), v);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size();
+}
+
+static bool read_file(const fs::path& p, std::string& s) {
+    std::ifstream f(p, std::ios::binary);
+    if (!f) return false;
+
+    std::ostringstream ss;
+    ss << f.rdbuf();
+    s = ss.str();
+    return true;
+}
+
+// Lines without trailing blanks, less the blank lines at the end: what
+// the judge ignores when it compares outputs.
+static std::vector<std::string_view> lines_of(std::string_view s) {
+    std::vector<std::string_view> v;
+
+    while (!s.empty()) {
+        auto nl = s.find('\n');
+        std::string_view l = s.substr(0, nl);
+
+        while (!l.empty() && (l.back() == ' ' || l.back() == '\t' || l.back() == '\r')) l.remove_suffix(1);
+        v.push_back(l);
+
+        if (nl == std::string_view::npos) break;
+        s.remove_prefix(nl + 1);
+    }
+
+    while (!v.empty() && v.back().empty()) v.pop_back();
+    return v;
+}
+
+judge::options_t judge::default_options() {
+    options_t o;
+
+    const char* cxx = std::getenv("CXX");
+    o.cxx = cxx && *cxx ? cxx : "g++";
+
+    if (const char* f = std::getenv("BJMGR_CXXFLAGS"); f && *f) {
+        std::istringstream ss(f);
+        for (std::string w; ss >> w; ) o.flags.push_back(w);
+    } else o.flags.assign(std::begin(default_flags), std::end(default_flags));
+
+    return o;
+}
+
+fs::path judge::cache_dir() {
+    if (const char* e = std::getenv("BJMGR_BUILD_CACHE"); e && *e) return e;
+    if (const char* e = std::getenv("XDG_CACHE_HOME"); e && *e) return fs::path(e) / "bjmgr" / "build";
+    if (const char* e = std::getenv("HOME"); e && *e) return fs::path(e) / ".cache" / "bjmgr" / "build";
+
+    return fs::temp_directory_path() / ("bjmgr-build-" + std::to_string(getuid()));
+}
+
+std::string judge::compiler_version(const options_t& opts) {
+    auto r = spawn({ opts.cxx, "--version" }, nullptr, true, 10000);
+    if (!exited_ok(r)) return "";
+
+    return r.out.substr(0, r.out.find('\n'));
+}
+
+namespace {
+
+// Builds into the cache for one compiler and flags.
+struct builder {
+    const judge::options_t& opts;
+    u64 cfg = 0xcbf29ce484222325ull;
+    fs::path bin, pch;
+
+    // The shared header, built by the first target that needs a compile.
+    std::once_flag pch_once;
+    std::string pch_dir;
+
+    explicit builder(const judge::options_t& __opts)
+    : opts(__opts) {
+        // Everything besides the source that goes into a binary.
+        auto ver = spawn({ opts.cxx, "--version" }, nullptr, true, 10000);
+        const std::string_view sep("", 1);
+
+        cfg = fnv(cfg, opts.cxx);
+        for (auto& f : opts.flags) cfg = fnv(fnv(cfg, sep), f);
+        cfg = fnv(fnv(cfg, sep), ver.out);
+
+        fs::path cache = judge::cache_dir();
+        bin = cache / "bin";
+        pch = cache / "pch" / hex(cfg);
+
+        std::error_code ec;
+        fs::create_directories(bin, ec);
+    }
+
+    std::vector<std::string> compiler() const {
+        std::vector<std::string> av { opts.cxx };
+        av.insert(av.end(), opts.flags.begin(), opts.flags.end());
+        return av;
+    }
+
+    // The stub the header is built from forwards to the real one, so a
+    // compile the PCH does not apply to still works. A failed build is
+    // remembered and not tried again for the same compiler and flags.
+    void build_pch() {
+        PROF_SCOPE("pch", "build");
+
+        std::error_code ec;
+        fs::path h = pch / "bits" / "stdc++.h", g = h, failed = pch / "failed";
+        g += ".gch";
+
+        if (fs::exists(g, ec)) { pch_dir = pch.string(); return; }
+        if (fs::exists(failed, ec)) return;
+
+        fs::create_directories(h.parent_path(), ec);
+        std::ofstream(h) << "#include_next <bits/stdc++.h>\n";
+
+        fs::path tmp = g;
+        tmp += ".tmp." + std::to_string(getpid());
+
+        auto av = compiler();
+        av.insert(av.end(), { "-x", "c++-header", h.string(), "-o", tmp.string() });
+
+        if (exited_ok(spawn(av, nullptr, true, compile_timeout_ms))) {
+            fs::rename(tmp, g, ec);
+            if (!ec) { pch_dir = pch.string(); return; }
+        }
+
+        fs::remove(tmp, ec);
+        std::ofstream { failed };
+    }
+
+    // Binary of t, cached or built now, with rep.build set and key set to
+    // the hash it is cached by. Empty if there is none.
+    fs::path build(const fs::path& root, const judge::target_t& t, judge::report_t& rep, u64& key) {
+        using report_t = judge::report_t;
+
+        rep.target = t;
+
+        const char* ext = nullptr;
+        for (const char* e : { "cpp", "cc", "cxx" })
+            if (t.langs & lang::bit(e)) { ext = e; break; }
+
+        if (!ext) { rep.build = report_t::no_source; return { }; }
+
+        fs::path src = root / fs::path(t.tier.path()) / (std::to_string(t.id) + "." + ext);
+        std::string code;
+
+        if (!read_file(src, code)) {
+            rep.build = report_t::failed;
+            rep.log = "Cannot read '" + src.string() + "'\n";
+            return { };
+        }
+
+        key = fnv(cfg, code);
+
+        std::error_code ec;
+        fs::path exe = bin / hex(key);
+
+        if (fs::exists(exe, ec)) { rep.build = report_t::cached; return exe; }
+
+        std::call_once(pch_once, [this] { build_pch(); });
+
+        PROF_SCOPE("compile", "build", t.id);
+
+        // Renamed into place, so the cache never holds half a binary. The
+        // same source under two ids may compile twice; both renames land
+        // the same file.
+        fs::path tmp = exe;
+        tmp += ".tmp." + std::to_string(getpid()) + "." + std::to_string(t.id);
+
+        auto av = compiler();
+        if (!pch_dir.empty()) av.insert(av.end(), { "-I", pch_dir });
+        av.insert(av.end(), { src.string(), "-o", tmp.string() });
+
+        auto r = spawn(av, nullptr, true, compile_timeout_ms);
+
+        if (exited_ok(r)) fs::rename(tmp, exe, ec);
+
+        if (!exited_ok(r) || ec) {
+            rep.build = report_t::failed;
+            rep.log = r.status < 0 ? "Cannot run '" + opts.cxx + "'\n" : ec ? ec.message() + "\n" : r.out;
+            fs::remove(tmp, ec);
+            return { };
+        }
+
+        rep.build = report_t::built;
+        return exe;
+    }
+};
+
+}
+
+// Sample directory of t.
+static fs::path samples_of(const fs::path& root, const judge::target_t& t) {
+    return root / fs::path(t.tier.path()) / std::to_string(t.id);
+}
+
+// Names of the "<name>.in" files in dir, numbered names in numeric order.
+// With need_out, only those with a matching "<name>.out".
+static std::vector<std::string> inputs_in(const fs::path& dir, bool need_out) {
+    std::error_code ec;
+    std::vector<std::string> names;
+
+    for (auto it = fs::directory_iterator(dir, ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+        fs::path p = it->path();
+        if (p.extension() != ".in") continue;
+
+        std::error_code e2;
+        if (!need_out || fs::exists(fs::path(p).replace_extension(".out"), e2)) names.push_back(p.stem().string());
+    }
+
+    std::sort(names.begin(), names.end(), [] (const std::string& a, const std::string& b) {
+        return a.size() != b.size() ? a.size() < b.size() : a < b;
+    });
+
+    return names;
+}
+
+std::vector<judge::report_t> judge::run(
+    const fs::path& root, const std::vector<target_t>& targets,
+    const options_t& opts, const std::function<void(const report_t&)>& on_done
+) {
+    std::vector<report_t> out(targets.size());
+    if (targets.empty()) return out;
+
+    builder b(opts);
+
+    auto test = [&] (const target_t& t, report_t& rep) {
+        u64 key;
+        fs::path exe = b.build(root, t, rep, key);
+        if (exe.empty()) return;
+
+        fs::path sd = samples_of(root, t);
+
+        for (auto& n : inputs_in(sd, true)) {
+            PROF_SCOPE("case", "run", t.id);
+
+            case_t c { n, case_t::pass, 0, "", "" };
+            std::string want;
+            read_file(sd / (n + ".out"), want);
+
+            fs::path in = sd / (n + ".in");
+            auto r = spawn({ exe.string() }, in.c_str(), false, opts.timeout_ms);
+            c.ms = r.ms;
+
+            if (r.timed_out) c.verdict = case_t::timeout;
+            else if (r.truncated) {
+                c.verdict = case_t::wrong;
+                c.got = "(more than " + std::to_string(output_cap >> 20) + " MiB of output)";
+            } else if (!exited_ok(r)) c.verdict = case_t::crash;
+            else {
+                auto a = lines_of(want), b = lines_of(r.out);
+                std::size_t k = 0;
+
+                while (k < a.size() && k < b.size() && a[k] == b[k]) k++;
+
+                if (k < a.size() || k < b.size()) {
+                    c.verdict = case_t::wrong;
+                    c.expected = k < a.size() ? std::string(a[k]) : "(end of output)";
+                    c.got = k < b.size() ? std::string(b[k]) : "(end of output)";
+                }
+            }
+
+            rep.cases.push_back(std::move(c));
+        }
+    };
+
+    std::atomic<std::size_t> next { 0 };
+    std::mutex done_mtx;
+
+    auto work = [&] {
+        for (std::size_t i; (i = next++) < targets.size(); ) {
+            test(targets[i], out[i]);
+
+            if (on_done) {
+                std::lock_guard<std::mutex> lk(done_mtx);
+                on_done(out[i]);
+            }
+        }
+    };
+
+    std::size_t n = opts.jobs > 0 ? opts.jobs : std::max(1u, std::thread::hardware_concurrency());
+    n = std::min(n, targets.size());
+
+    std::vector<std::thread> pool;
+
+    for (std::size_t t = 1; t < n; t++) pool.emplace_back(work);
+    work();
+    for (auto& t : pool) t.join();
+
+    return out;
+}
+
+// Counters of judge::timing_t, in its order.
+static constexpr std::pair<u32, u64> counter_events[] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES }
+};
+
+static_assert(std::size(counter_events) == sizeof(judge::timing_t::counters) / sizeof(i64));
+
+// User-space counter of pid and its children, armed to start at its exec.
+static int open_counter(pid_t pid, u32 type, u64 config) {
+    perf_event_attr a { };
+    a.size = sizeof(a);
+    a.type = type;
+    a.config = config;
+    a.disabled = 1;
+    a.enable_on_exec = 1;
+    a.inherit = 1;
+    a.exclude_kernel = 1;
+    a.exclude_hv = 1;
+
+    return (int)syscall(SYS_perf_event_open, &a, pid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+
+struct usage_t {
+    bool ok = false;
+    i64 wall_us = 0, cpu_us = 0, rss_kb = 0;
+    i64 counters[std::size(counter_events)];
+};
+
+// One run of exe on in, with its output dropped. The child is forked
+// rather than spawned so it can pin itself to cpu and take a CPU time
+// limit, and it waits on a pipe until the counters are attached. Between
+// fork and exec it only makes system calls.
+static usage_t measure(const fs::path& exe, const fs::path& in, i32 cpu, bool counters, i64 timeout_ms) {
+    usage_t u;
+    for (auto& c : u.counters) c = -1;
+
+    int go[2];
+    if (pipe2(go, O_CLOEXEC)) return u;
+
+    int ifd = ::open(in.c_str(), O_RDONLY | O_CLOEXEC), nfd = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+    const char* path = exe.c_str();
+
+    rlimit lim;
+    lim.rlim_cur = (timeout_ms + 999) / 1000;
+    lim.rlim_max = lim.rlim_cur + 1;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+
+    pid_t pid = ifd < 0 || nfd < 0 ? -1 : fork();
+
+    if (pid == 0) {
+        char c;
+        if (::read(go[0], &c, 1) != 1) _exit(127);
+
+        dup2(ifd, 0);
+        dup2(nfd, 1);
+        dup2(nfd, 2);
+
+        // An unpinned timing would pass for a pinned one.
+        if (cpu >= 0 && sched_setaffinity(0, sizeof(set), &set)) _exit(126);
+        setrlimit(RLIMIT_CPU, &lim);
+
+        execl(path, path, (char*)nullptr);
+        _exit(127);
+    }
+
+    ::close(go[0]);
+    if (ifd >= 0) ::close(ifd);
+    if (nfd >= 0) ::close(nfd);
+
+    if (pid < 0) { ::close(go[1]); return u; }
+
+    int fds[std::size(counter_events)];
+
+    for (std::size_t i = 0; i < std::size(fds); i++)
+        fds[i] = counters ? open_counter(pid, counter_events[i].first, counter_events[i].second) : -1;
+
+    auto start = clock_type::now();
+    bool started = ::write(go[1], "", 1) == 1;
+    ::close(go[1]);
+
+    int st = 0;
+    rusage ru { };
+    bool timed_out = false;
+    auto deadline = start + std::chrono::milliseconds(timeout_ms);
+
+    // RLIMIT_CPU does not stop a program that sleeps or blocks, so the wall
+    // clock has a deadline too. The short sleep keeps the wall time within
+    // a tenth of a millisecond.
+    for (int w; ; ) {
+        if ((w = wait4(pid, &st, WNOHANG, &ru)) == pid) break;
+        if (w < 0 && errno != EINTR) break;
+
+        if (clock_type::now() >= deadline) { timed_out = true; break; }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    if (timed_out) {
+        kill(pid, SIGKILL);
+        while (wait4(pid, &st, 0, &ru) < 0 && errno == EINTR) { }
+    }
+
+    u.wall_us = std::chrono::duration_cast<std::chrono::microseconds>(clock_type::now() - start).count();
+    u.cpu_us =
+        (i64)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000 +
+        ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+    u.rss_kb = ru.ru_maxrss;
+    u.ok = started && !timed_out && WIFEXITED(st) && !WEXITSTATUS(st);
+
+    for (std::size_t i = 0; i < std::size(fds); i++) {
+        if (fds[i] < 0) continue;
+
+        u64 v;
+        if (::read(fds[i], &v, sizeof(v)) == sizeof(v)) u.counters[i] = v;
+        ::close(fds[i]);
+    }
+
+    return u;
+}
+
+// Median and 95th percentile (nearest rank) of v.
+static std::pair<i64, i64> med_p95(std::vector<i64> v) {
+    std::sort(v.begin(), v.end());
+    return { v[(v.size() - 1) / 2], v[(v.size() * 95 + 99) / 100 - 1] };
+}
+
+i32 judge::default_cpu() {
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set)) return -1;
+
+    for (i32 c = CPU_SETSIZE - 1; c >= 0; c--)
+        if (CPU_ISSET(c, &set)) return c;
+
+    return -1;
+}
+
+bool judge::cpu_allowed(i32 cpu) {
+    cpu_set_t set;
+    return cpu >= 0 && cpu < CPU_SETSIZE && !sched_getaffinity(0, sizeof(set), &set) && CPU_ISSET(cpu, &set);
+}
+
+judge::bench_t judge::bench(const fs::path& root, const target_t& t, const options_t& opts, const bench_options_t& bopts) {
+    bench_t out;
+    builder b(opts);
+    u64 key = 0;
+
+    fs::path exe = b.build(root, t, out.report, key);
+    if (exe.empty()) return out;
+
+    out.hash = hex(key);
+
+    fs::path sd = samples_of(root, t);
+
+    // Counters are tried on the first run; a kernel that refuses them
+    // (perf_event_paranoid, containers) refuses them every time.
+    bool counters = true;
+
+    for (auto& n : inputs_in(sd, false)) {
+        PROF_SCOPE("bench", "run", t.id);
+
+        fs::path in = sd / (n + ".in");
+        timing_t tm { n, true, 0, 0, 0, 0, 0, { -1, -1, -1, -1 } };
+
+        for (i32 i = 0; i < bopts.warmup; i++) tm.ok &= measure(exe, in, bopts.cpu, false, opts.timeout_ms).ok;
+
+        std::vector<i64> wall, cpu, ctr[std::size(counter_events)];
+
+        for (i32 i = 0; i < bopts.runs; i++) {
+            auto u = measure(exe, in, bopts.cpu, counters, opts.timeout_ms);
+
+            tm.ok &= u.ok;
+            wall.push_back(u.wall_us);
+            cpu.push_back(u.cpu_us);
+            tm.rss_kb = std::max(tm.rss_kb, u.rss_kb);
+
+            counters = counters && u.counters[0] >= 0;
+            for (std::size_t k = 0; k < std::size(ctr); k++)
+                if (u.counters[k] >= 0) ctr[k].push_back(u.counters[k]);
+        }
+
+        std::tie(tm.wall_med, tm.wall_p95) = med_p95(wall);
+        std::tie(tm.cpu_med, tm.cpu_p95) = med_p95(cpu);
+
+        for (std::size_t k = 0; k < std::size(ctr); k++)
+            if (counters && ctr[k].size() == wall.size()) tm.counters[k] = med_p95(ctr[k]).first;
+
+        out.inputs.push_back(std::move(tm));
+    }
+
+    return out;
+}
+
+// Every line after the header is
+// "<id>\t<hash>\t<time>\t<input>\t<wall med>\t<wall p95>\t<cpu med>\t<cpu p95>\t<rss>\t<counters>",
+// times in microseconds and the counters separated by ','.
+static constexpr std::string_view bench_header = "bjmgr-bench 1";
+
+fs::path judge::bench_path(const fs::path& root) {
+    return root / ".bjmgr" / "bench";
+}
+
+std::vector<judge::saved_t> judge::load_bench(const fs::path& root) {
+    std::vector<saved_t> out;
+    std::string buf;
+
+    if (!read_file(bench_path(root), buf)) return out;
+
+    bool header = true, known = true;
+
+    strlib::split_views(buf, '\n', [&] (std::string_view ln) {
+        if (header) { header = false; known = ln == bench_header; return; }
+        if (!known || ln.empty()) return;
+
+        std::string_view f[10];
+        i32 k = 0;
+        strlib::split_views(ln, '\t', [&] (std::string_view x) { if (k < 10) f[k] = x; k++; });
+
+        saved_t s { };
+        s.hash = f[1];
+        s.timing.name = f[3];
+        s.timing.ok = true;
+
+        bool ok = k == 10 &&
+            parse_num(f[0], s.id) && parse_num(f[2], s.ts) &&
+            parse_num(f[4], s.timing.wall_med) && parse_num(f[5], s.timing.wall_p95) &&
+            parse_num(f[6], s.timing.cpu_med) && parse_num(f[7], s.timing.cpu_p95) &&
+            parse_num(f[8], s.timing.rss_kb);
+
+        i32 n = 0;
+        strlib::split_views(f[9], ',', [&] (std::string_view x) {
+            if (n < 4 && !parse_num(x, s.timing.counters[n])) ok = false;
+            n++;
+        });
+
+        if (ok && n == 4) out.push_back(std::move(s));
+    });
+
+    return out;
+}
+
+bool judge::save_bench(const fs::path& root, i32 id, const std::string& hash, i64 ts, const std::vector<timing_t>& inputs) {
+    auto old = load_bench(root);
+
+    std::string out(bench_header);
+    out += '\n';
+
+    auto line = [&] (i32 id, const std::string& hash, i64 ts, const timing_t& t) {
+        strlib::append(out, id); out += '\t';
+        out += hash; out += '\t';
+        strlib::append(out, ts); out += '\t';
+        out += t.name; out += '\t';
+
+        for (i64 v : { t.wall_med, t.wall_p95, t.cpu_med, t.cpu_p95, t.rss_kb }) { strlib::append(out, v); out += '\t'; }
+
+        strlib::append_join(out, std::begin(t.counters), std::end(t.counters), ",");
+        out += '\n';
+    };
+
+    // A rerun of the same build replaces its results.
+    for (auto& s : old)
+        if (s.id != id || s.hash != hash) line(s.id, s.hash, s.ts, s.timing);
+
+    for (auto& t : inputs) line(id, hash, ts, t);
+
+    std::error_code ec;
+    fs::path file = bench_path(root), tmp = file;
+    tmp += ".tmp." + std::to_string(getpid());
+
+    fs::create_directories(file.parent_path(), ec);
+
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+
+    bool ok = std::fwrite(out.data(), 1, out.size(), f) == out.size();
+    ok = std::fclose(f) == 0 && ok;
+
+    if (ok) fs::rename(tmp, file, ec);
+    if (!ok || ec) { fs::remove(tmp, ec); return false; }
+
+    return true;
+}
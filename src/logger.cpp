@@ -0,0 +1,225 @@
+#include "logger.h"
+#include "tier.h"
+#include "ansi.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+static std::atomic<log_sink*> _active { nullptr };
+
+static void close_active() {
+    if (auto* s = _active.load()) s->close();
+}
+
+static const char* phase_str[] = {
+    "run", "fetch", "diff", "patch", "check", "create"
+};
+
+static const char* result_str[] = {
+    "ok", "fail", "skip", "cancel", "invalid", "present", "missing"
+};
+
+static void json_escape(const std::string& s, std::string& out) {
+    for (unsigned char c : s) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char tmp[8];
+                    std::snprintf(tmp, sizeof(tmp), "\\u%04x", c);
+                    out += tmp;
+                } else out += c;
+        }
+    }
+}
+
+static void colored_tier(i8 lv, std::string& out) {
+    tier_t t(lv);
+    out += t.ansi(); out += t.long_name(); out += RESET;
+}
+
+log_sink::log_sink(const std::filesystem::path& __path, format __fmt)
+: _out(__path, std::ios::binary), _fmt(__fmt) {
+    node* stub = new node;
+    _head.store(stub);
+    _tail = stub;
+
+    static bool registered = false;
+    if (!registered) { std::atexit(close_active); registered = true; }
+    _active.store(this);
+
+    _th = std::thread(&log_sink::run, this);
+}
+
+log_sink::~log_sink() {
+    close();
+
+    log_sink* self = this;
+    _active.compare_exchange_strong(self, nullptr);
+
+    delete _tail;
+}
+
+bool log_sink::parse_format(const std::string& s, format& f) {
+    if (s == "json") { f = format::json; return true; }
+    if (s == "text") { f = format::text; return true; }
+    return false;
+}
+
+void log_sink::push(log_record r) {
+    r.ts = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+
+    node* n = new node;
+    n->rec = std::move(r);
+
+    node* prev = _head.exchange(n, std::memory_order_acq_rel);
+
+    // Sequentially consistent with the worker's _waiting store and its
+    // recheck of the queue: either it sees this node, or we see it waiting.
+    prev->next.store(n);
+    if (_waiting.load()) wake();
+}
+
+void log_sink::wake() {
+    { std::lock_guard<std::mutex> lk(_mtx); }
+    _cv.notify_one();
+}
+
+void log_sink::close() {
+    if (!_th.joinable()) return;
+
+    _stop.store(true);
+    wake();
+    _th.join();
+    _out.flush();
+}
+
+// Pops everything currently linked into `out`. Returns false if the queue was empty.
+bool log_sink::drain(std::string& out) {
+    bool any = false;
+
+    for (;;) {
+        node* next = _tail->next.load(std::memory_order_acquire);
+        if (!next) break;
+
+        render(next->rec, out);
+        delete _tail;
+        _tail = next;
+        any = true;
+
+        if (out.size() >= (1 << 16)) {
+            _out.write(out.data(), out.size());
+            out.clear();
+        }
+    }
+
+    return any;
+}
+
+void log_sink::run() {
+    std::string buf;
+    buf.reserve(1 << 17);
+
+    for (;;) {
+        bool stop = _stop.load(std::memory_order_acquire);
+
+        // push() links its node before returning, so everything pushed
+        // before close() is visible to the pass that observes the stop.
+        bool any = drain(buf);
+
+        if (!buf.empty()) {
+            _out.write(buf.data(), buf.size());
+            buf.clear();
+        }
+
+        if (stop && !any) break;
+        if (any || stop) continue;
+
+        std::unique_lock<std::mutex> lk(_mtx);
+        _waiting.store(true);
+        _cv.wait(lk, [&] { return _tail->next.load() || _stop.load(); });
+        _waiting.store(false);
+    }
+}
+
+void log_sink::render(const log_record& r, std::string& out) const {
+    std::time_t sec = r.ts / 1000;
+
+    if (_fmt == format::json) {
+        std::tm tm; gmtime_r(&sec, &tm);
+        char ts[40];
+        std::strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%S", &tm);
+
+        out += "{\"ts\":\""; out += ts;
+        char ms[8]; std::snprintf(ms, sizeof(ms), ".%03dZ", (int)(r.ts % 1000));
+        out += ms;
+        out += "\",\"phase\":\""; out += phase_str[(i32)r.phase];
+        out += "\",\"result\":\""; out += result_str[(i32)r.result]; out += '"';
+
+        if (r.id) { out += ",\"id\":"; out += std::to_string(r.id); }
+        if (r.old_level >= 0) { out += ",\"old\":"; out += std::to_string(r.old_level); }
+        if (r.new_level >= 0) { out += ",\"new\":"; out += std::to_string(r.new_level); }
+        if (!r.msg.empty()) { out += ",\"msg\":\""; json_escape(r.msg, out); out += '"'; }
+
+        out += "}\n";
+        return;
+    }
+
+    std::string id = std::to_string(r.id);
+
+    switch (r.phase) {
+        case log_phase::run: {
+            if (r.result == log_result::cancel) { out += r.msg + "\n"; break; }
+
+            std::tm tm; localtime_r(&sec, &tm);
+            char ts[64];
+            std::strftime(ts, sizeof(ts), "%c %Z", &tm);
+            out += ts; out += "\n\n";
+        } break;
+        case log_phase::fetch:
+            if (r.result == log_result::fail) {
+                out +=
+                    "/* Debug Informations */" "\n" + r.msg + "\n"
+                    "/* End of Debug Informations */" "\n";
+                break;
+            }
+
+            out += "Data fetched : " + id + " => ";
+            colored_tier(r.new_level, out);
+            out += "\n";
+            break;
+        case log_phase::diff:
+            out += "Diff : " + id + " : ";
+            colored_tier(r.old_level, out);
+            out += " <-> ";
+            colored_tier(r.new_level, out);
+            out += "\n";
+            break;
+        case log_phase::patch:
+            if (r.result == log_result::ok)
+                out += "Patching Success (" + id + ")\n";
+            else if (r.result == log_result::invalid)
+                out += "[" COLORED_ERROR "] Cannot patch as the tier is invalid or Unrated (" + id + ")\n";
+            else
+                out += "[" COLORED_ERROR "] Patching Failed (" + id + ") : " + r.msg + "\n";
+            break;
+        case log_phase::check:
+            out += "[";
+            colored_tier(r.new_level, out);
+            out += "] " + id + " : ";
+            out += r.result == log_result::present ? COLOR(46) "✔" RESET "\n" : COLOR(160) "✘" RESET "\n";
+            break;
+        case log_phase::create:
+            out += r.result == log_result::skip ? "File skipped : " : "File created : ";
+            out += r.msg + "\n";
+            break;
+    }
+}
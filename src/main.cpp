@@ -1,50 +1,45 @@
-#include <iostream>
 #include <vector>
 #include <string>
-#include <sstream>
-#include <map>
-#include <unordered_set>
 #include <filesystem>
 #include <fstream>
-#include <iterator>
-#include <tuple>
+#include <deque>
+#include <map>
+#include <algorithm>
 #include <utility>
+#include <functional>
 
+#include <cerrno>
+#include <cctype>
+#include <cmath>
 #include <ctime>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
 
-#include <curl/curl.h>
-#include <nlohmann/json.hpp>
+#include <unistd.h>
+#include <poll.h>
 
+#include "ansi.h"
 #include "ioutil.h"
+#include "logger.h"
+#include "output.h"
+#include "progress.h"
+#include "profile.h"
+#include "metrics.h"
 #include "strlib.h"
 #include "arg.h"
 #include "tier.h"
 #include "problem.h"
-
-#ifdef ANSI_ENABLED
-#define USE_COLOR(x) "\033[" #x "m"
-#else
-#define USE_COLOR(x) ""
-#endif
-#define RESET USE_COLOR(0)
-#define COLOR(x) USE_COLOR(38;5;x)
-#define COLORED_TEXT(x, s) COLOR(x) s RESET
-#define COLORED_APP_NAME COLOR(214) APP_NAME COLOR(0) RESET
-#define COLORED_USAGE COLOR(112) "Usage" RESET
-#define COLORED_MENU(s) COLOR(218) s RESET
-#define COLORED_ERROR COLOR(160) "Error" RESET
-
-#define API_VERSION "v3"
-#define BASE_URL "https://solved.ac/api/" API_VERSION "/"
-
-using namespace nlohmann;
+#include "service.h"
+#include "bjmgr.h"
+#include "catalog.h"
+#include "history.h"
+#include "lang.h"
+#include "judge.h"
 
 namespace fs = std::filesystem;
 
-problem_t get_problem(i32 n);
-
-static std::unordered_map<std::string, std::string> help_table {
-    { "info",
+static constexpr std::string_view info_help =
     COLORED_USAGE ": " APP_NAME " info [options]"                                    "\n"
     ""                                                                              "\n"
     "  Collects problems by difficulty according to the specified folder structure" "\n"
@@ -52,7 +47,12 @@ static std::unordered_map<std::string, std::string> help_table {
     ""                                                                              "\n"
     COLORED_MENU("Options")                                                         "\n"
     "  --search <tier>    -s : filter information by tier"                          "\n"
+    "  --tag <tags>       -g : only problems with every tag (!tag excludes)"         "\n"
+    "  --histogram           : count problems per tag"                              "\n"
+    "  --crosstab            : count problems per tag and tier"                     "\n"
+    "  --stats               : count files, stubs, lines and bytes"                 "\n"
     "  --dir <path>       -d : set working directory"                               "\n"
+    "  --profile <file>      : write a Chrome trace and timing summary"             "\n"
     ""                                                                              "\n"
     COLORED_MENU("Examples")                                                        "\n"
     "  " APP_NAME " info                get all information"                        "\n"
@@ -61,8 +61,16 @@ static std::unordered_map<std::string, std::string> help_table {
     "  " APP_NAME " info -s d           get information from d5 to d1 tier"         "\n"
     "  " APP_NAME " info -s b3..        get information above b3 tier"              "\n"
     "  " APP_NAME " info -s ..p2        get information below p2 tier"              "\n"
-    },
-    { "patch", 
+    "  " APP_NAME " info -s b..g,!s1    get information from b5 to g1 except s1"    "\n"
+    "  " APP_NAME " info --tag dp,graphs"                                           "\n"
+    "                               get problems tagged both dp and graphs"          "\n"
+    "  " APP_NAME " info -s g --histogram"                                          "\n"
+    "                               count gold problems per tag"                    "\n"
+    "  " APP_NAME " info --stats        get lines of code per tier and extension"    "\n"
+    ""                                                                              "\n"
+    "  Tags come from the catalog kept for 'search' ('" APP_NAME " search --sync')." "\n";
+
+static constexpr std::string_view patch_help =
     COLORED_USAGE ": " APP_NAME " patch [options]"      "\n"
     ""                                                  "\n"
     "  Fetches tiers from solved.ac and moves files"    "\n"
@@ -70,35 +78,45 @@ static std::unordered_map<std::string, std::string> help_table {
     ""                                                  "\n"
     COLORED_MENU("Options")                             "\n"
     "  --log <path>      -l : set log output file."     "\n"
+    "  --log-format <fmt>   : text (default) or json."  "\n"
     "  --dir <path>      -d : set working directory."   "\n"
     "  --yes             -y : skip confirmation."       "\n"
+    "  --profile <file>     : write a Chrome trace."    "\n"
+    "  --metrics <file>     : write Prometheus metrics." "\n"
     ""                                                  "\n"
     COLORED_MENU("Examples")                            "\n"
     "  " APP_NAME " patch"                              "\n"
 //  "  " APP_NAME " patch --cache \"../cache\""         "\n" Why is this code left?
 //  "  " APP_NAME " patch -c\"../cache/p1.txt\""        "\n" TODO: Add feature or remove examples.
-    "  " APP_NAME " patch -l\"./log.txt\""              "\n"
-    },
-    { "get",
-    COLORED_USAGE ": " APP_NAME " get <problem-id>"                                     "\n"
+    "  " APP_NAME " patch -l\"./log.txt\""              "\n";
+
+static constexpr std::string_view get_help =
+    COLORED_USAGE ": " APP_NAME " get <problem-id>... [options]"                          "\n"
     ""                                                                                  "\n"
-    "  Gets information from solved.ac with the problem id."                            "\n"
+    "  Gets information from solved.ac with the problem ids."                           "\n"
+    "  Without ids (or with '-'), ids are read from stdin and printed as they arrive."  "\n"
     ""                                                                                  "\n"
     COLORED_MENU("Required")                                                            "\n"
-    "  <problem-id>         : problem id (required)"                                   "\n"
+    "  <problem-id>...      : problem ids, or '-' for stdin"                            "\n"
+    ""                                                                                  "\n"
+    COLORED_MENU("Options")                                                             "\n"
+    "  --profile <file>     : write a Chrome trace."                                    "\n"
     ""                                                                                  "\n"
     COLORED_MENU("Examples")                                                            "\n"
     "  " APP_NAME " get 1000"                                                           "\n"
-    "  " APP_NAME " get 11440"                                                          "\n"
-    },
-    { "new",
-    COLORED_USAGE ": " APP_NAME " new <problem-id> [options]"                      "\n"
+    "  " APP_NAME " get 1000 1001 11440"                                                "\n"
+    "  cat contest.txt | " APP_NAME " get"                                              "\n";
+
+static constexpr std::string_view new_help =
+    COLORED_USAGE ": " APP_NAME " new <problem-id>... [options]"                   "\n"
     ""                                                                             "\n"
     "  Fetches the tier from solved.ac"                                            "\n"
     "  and creates a new file in the corresponding tier folder."                   "\n"
+    "  Without ids (or with '-'), ids are read from stdin; existing files are"     "\n"
+    "  then skipped unless --yes is given."                                        "\n"
     ""                                                                             "\n"
     COLORED_MENU("Required")                                                       "\n"
-    "  <problem-id>         : problem id (required)"                               "\n"
+    "  <problem-id>...      : problem ids, or '-' for stdin"                       "\n"
     ""                                                                             "\n"
     COLORED_MENU("Options")                                                        "\n"
     "  --dir <path>      -d : set working directory."                              "\n"
@@ -106,12 +124,14 @@ static std::unordered_map<std::string, std::string> help_table {
     "  --extension <ext> -x : set file extension (default is cpp)."                "\n"
     "  --yes             -y : skip confirmation."                                  "\n"
     "  --code            -c : open file with code. " COLORED_TEXT(160, "(unsafe)") "\n"
+    "  --profile <file>     : write a Chrome trace."                               "\n"
     ""                                                                             "\n"
     COLORED_MENU("Examples")                                                       "\n"
     "  " APP_NAME " new 1000"                                                      "\n"
     "  " APP_NAME " new 3024 -d../ -tD3 -xcpp"                                     "\n"
-        },
-        { "update",
+    "  " APP_NAME " new 1000 1001 1002 -y"                                         "\n";
+
+static constexpr std::string_view update_help =
     COLORED_USAGE ": " APP_NAME " update <username> [options]"                      "\n"
     ""                                                                              "\n"
     "  Gets all solved problems of the user from solved.ac"                         "\n"
@@ -119,110 +139,379 @@ static std::unordered_map<std::string, std::string> help_table {
     ""                                                                              "\n"
     COLORED_MENU("Options")                                                         "\n"
     "  --log <path>      -l : set log output file."                                 "\n"
+    "  --log-format <fmt>   : text (default) or json."                              "\n"
     "  --dir <path>      -d : set working directory."                               "\n"
     "  --filter <tier>   -f : filter by tier."                                      "\n"
     "  --extension <ext> -x : set file extension (default is cpp)."                 "\n"
     "  --yes             -y : skip confirmation."                                   "\n"
     "  --code            -c : open files with code. " COLORED_TEXT(160, "(unsafe)") "\n"
+    "  --profile <file>     : write a Chrome trace."                                "\n"
+    "  --metrics <file>     : write Prometheus textfile metrics."                   "\n"
     ""                                                                              "\n"
     COLORED_MENU("Examples")                                                        "\n"
     "  " APP_NAME " update solvedac"                                                "\n"
     "  " APP_NAME " update solvedac -d../"                                          "\n"
     "  " APP_NAME " update solvedac --log \"./log.txt\""                            "\n"
     "  " APP_NAME " update solvedac --filter s..d3"                                 "\n"
-    }
-};
+    "  " APP_NAME " update solvedac --filter d..,!r"                                "\n";
 
-static std::unordered_map<std::string, std::string> short_desc {
-    { "info", "Gets tier information in current/specific directory." },
-    { "patch", "Updates tier and moves files to the correct directory." },
-    { "get", "Gets tier information with problem id" },
-    { "new", "Create new file with tier" },
-    { "update", "Updates source code that are solved but not in the directory." },
-    { "help", "Show help" }
-};
+static constexpr std::string_view search_help =
+    COLORED_USAGE ": " APP_NAME " search <text> [options]"                          "\n"
+    ""                                                                              "\n"
+    "  Searches problem titles offline, in the catalog kept from every title"      "\n"
+    "  fetched from solved.ac. Case is ignored for latin letters."                 "\n"
+    ""                                                                              "\n"
+    COLORED_MENU("Options")                                                         "\n"
+    "  --tier <tier>     -t : only problems in the tier range."                     "\n"
+    "  --local           -l : only problems solved in the directory."               "\n"
+    "  --missing         -m : only problems not in the directory."                  "\n"
+    "  --dir <path>      -d : set working directory."                               "\n"
+    "  --limit <n>       -n : show at most n results (default 50, 0 for all)."      "\n"
+    "  --sync               : fetch every problem from solved.ac first."            "\n"
+    "  --profile <file>     : write a Chrome trace."                                "\n"
+    ""                                                                              "\n"
+    COLORED_MENU("Examples")                                                        "\n"
+    "  " APP_NAME " search --sync"                                                  "\n"
+    "  " APP_NAME " search 수열"                                                    "\n"
+    "  " APP_NAME " search \"a+b\" -t b"                                            "\n"
+    "  " APP_NAME " search 트리 -t g..p --missing"                                  "\n";
+
+static constexpr std::string_view next_help =
+    COLORED_USAGE ": " APP_NAME " next [options]"                                    "\n"
+    ""                                                                              "\n"
+    "  Suggests unsolved problems to practice, from the offline catalog. Problems"  "\n"
+    "  are ranked by how well their level fits the levels solved in the directory," "\n"
+    "  by how underrepresented their tags are there, and by popularity."           "\n"
+    ""                                                                              "\n"
+    COLORED_MENU("Options")                                                         "\n"
+    "  --tier <tier>     -t : only problems in the tier range."                     "\n"
+    "  --count <n>       -n : number of suggestions (default 10)."                  "\n"
+    "  --dir <path>      -d : set working directory."                               "\n"
+    "  --profile <file>     : write a Chrome trace."                                "\n"
+    ""                                                                              "\n"
+    COLORED_MENU("Examples")                                                        "\n"
+    "  " APP_NAME " next"                                                           "\n"
+    "  " APP_NAME " next -t g -n 20"                                                "\n";
+
+static constexpr std::string_view history_help =
+    COLORED_USAGE ": " APP_NAME " history [problem ids] [options]"                  "\n"
+    ""                                                                              "\n"
+    "  Shows the level changes patch has applied in the directory, oldest first."   "\n"
+    ""                                                                              "\n"
+    COLORED_MENU("Options")                                                         "\n"
+    "  --since <date>    -s : only changes from the date on (YYYY-MM-DD or YYYY-MM)." "\n"
+    "  --until <date>    -u : only changes before the date."                        "\n"
+    "  --monthly         -m : count changes per month instead of listing them."     "\n"
+    "  --dir <path>      -d : set working directory."                               "\n"
+    ""                                                                              "\n"
+    COLORED_MENU("Examples")                                                        "\n"
+    "  " APP_NAME " history --since 2026-01-01"                                     "\n"
+    "  " APP_NAME " history 1000 1001"                                              "\n"
+    "  " APP_NAME " history -m -s 2025-01"                                          "\n";
+
+static constexpr std::string_view test_help =
+    COLORED_USAGE ": " APP_NAME " test [problem ids | tier range] [options]"        "\n"
+    ""                                                                              "\n"
+    "  Compiles the C++ solutions in the directory and runs them against their"    "\n"
+    "  sample tests, '<id>/<name>.in' and '<id>/<name>.out' next to the solution." "\n"
+    "  With no argument every solution is tested. Binaries are cached by source"  "\n"
+    "  and flags, and compiles share a precompiled <bits/stdc++.h>."               "\n"
+    "  The compiler is $CXX (default g++), with $BJMGR_CXXFLAGS if set."           "\n"
+    ""                                                                              "\n"
+    COLORED_MENU("Options")                                                         "\n"
+    "  --jobs <n>        -j : run n builds and tests at once (default: cores)."     "\n"
+    "  --timeout <ms>       : time limit of one test (default 5000)."               "\n"
+    "  --dir <path>      -d : set working directory."                               "\n"
+    "  --profile <file>     : write a Chrome trace."                                "\n"
+    ""                                                                              "\n"
+    COLORED_MENU("Examples")                                                        "\n"
+    "  " APP_NAME " test"                                                           "\n"
+    "  " APP_NAME " test 1000 1001"                                                 "\n"
+    "  " APP_NAME " test g -j 4"                                                    "\n";
+
+static constexpr std::string_view bench_help =
+    COLORED_USAGE ": " APP_NAME " bench <problem id> [options]"                    "\n"
+    ""                                                                              "\n"
+    "  Times a C++ solution on each of its sample inputs, '<id>/<name>.in' next"   "\n"
+    "  to the solution. Runs are pinned to one CPU and follow a few untimed ones." "\n"
+    "  Results are kept per build, and the next build of the same problem is"      "\n"
+    "  compared with them."                                                        "\n"
+    ""                                                                              "\n"
+    COLORED_MENU("Options")                                                         "\n"
+    "  --runs <n>        -n : timed runs per input (default 10)."                   "\n"
+    "  --warmup <n>      -w : untimed runs first (default 2)."                      "\n"
+    "  --cpu <n>            : pin runs to CPU n (default: the last one allowed)."   "\n"
+    "  --timeout <ms>       : CPU and wall time limit of one run (default 5000)."   "\n"
+    "  --dir <path>      -d : set working directory."                               "\n"
+    "  --profile <file>     : write a Chrome trace."                                "\n"
+    ""                                                                              "\n"
+    COLORED_MENU("Examples")                                                        "\n"
+    "  " APP_NAME " bench 1000"                                                     "\n"
+    "  " APP_NAME " bench 1000 -n 50 --cpu 2"                                       "\n";
+
+static constexpr std::string_view fsck_help =
+    COLORED_USAGE ": " APP_NAME " fsck [options]"                                   "\n"
+    ""                                                                              "\n"
+    "  Checks the tier folders of the directory: problems with solutions in more"  "\n"
+    "  than one folder, file names that are not '<id>.<ext>', folders that are"    "\n"
+    "  not a level of their tier, sample folders with no solution beside them,"    "\n"
+    "  and solutions whose folder does not match the level cached by search."     "\n"
+    "  Moved solutions take their sample folder along. Nothing is fetched."        "\n"
+    ""                                                                              "\n"
+    COLORED_MENU("Options")                                                         "\n"
+    "  --fix             -f : move misplaced solutions to their level."             "\n"
+    "  --yes             -y : do not ask before moving."                            "\n"
+    "  --dir <path>      -d : set working directory."                               "\n"
+    "  --profile <file>     : write a Chrome trace."                                "\n"
+    ""                                                                              "\n"
+    COLORED_MENU("Examples")                                                        "\n"
+    "  " APP_NAME " fsck"                                                           "\n"
+    "  " APP_NAME " fsck --fix -y -d ./solutions"                                   "\n";
 
-static std::unordered_map<std::string, std::vector<opt_t>> opt_table {
-    { "help", { } },
-    { "info", {
-        { "search", true, 's' },
-        { "dir", true, 'd' }
-    } },
-    { "patch", {
-        { "log", true, 'l' },
-        { "dir", true, 'd' },
-        { "yes", false, 'y' }
-    } },
-    { "get", { } },
-    { "new", {
-        { "dir", true, 'd' },
-        { "tier", true, 't' },
-        { "extension", true, 'x' },
-        { "yes", false, 'y' },
-        { "code", false, 'c' }
-    } },
-    { "update", {
-        { "log", true, 'l' },
-        { "dir", true, 'd' },
-        { "filter", true, 'f' },
-        { "extension", true, 'x' },
-        { "yes", false, 'y' },
-        { "code", false, 'c' }
-    } }
+static constexpr std::string_view daemon_help =
+    COLORED_USAGE ": " APP_NAME " daemon [options]"                                 "\n"
+    ""                                                                              "\n"
+    "  Serves info, get and new from a long-running process. While it runs, those" "\n"
+    "  commands are forwarded to it and reuse its workspace index, problem cache"  "\n"
+    "  and connection to solved.ac. Stop it with Ctrl-C or SIGTERM."               "\n"
+    "  Ids from stdin and new without --yes, which may ask first, run locally."   "\n"
+    "  Set BJMGR_NO_DAEMON=1 to run a command locally anyway."                     "\n"
+    ""                                                                              "\n"
+    COLORED_MENU("Options")                                                         "\n"
+    "  --socket <path>   -s : listen on path (default is $BJMGR_SOCKET,"           "\n"
+    "                         $XDG_RUNTIME_DIR/bjmgr.sock or /tmp/bjmgr-<uid>.sock)" "\n"
+    ""                                                                              "\n"
+    COLORED_MENU("Examples")                                                        "\n"
+    "  " APP_NAME " daemon &"                                                       "\n"
+    "  " APP_NAME " info                answered by the daemon"                     "\n";
+
+static constexpr auto help_opts = opt_table_t<0>();
+
+static constexpr auto info_opts = make_options({
+    { "search", true, 's' },
+    { "tag", true, 'g' },
+    { "histogram", false },
+    { "crosstab", false },
+    { "stats", false },
+    { "dir", true, 'd' },
+    { "profile", true }
+});
+
+static constexpr auto patch_opts = make_options({
+    { "log", true, 'l' },
+    { "log-format", true },
+    { "dir", true, 'd' },
+    { "yes", false, 'y' },
+    { "profile", true },
+    { "metrics", true }
+});
+
+static constexpr auto get_opts = make_options({
+    { "profile", true }
+}, true);
+
+static constexpr auto new_opts = make_options({
+    { "dir", true, 'd' },
+    { "tier", true, 't' },
+    { "extension", true, 'x' },
+    { "yes", false, 'y' },
+    { "code", false, 'c' },
+    { "profile", true }
+}, true);
+
+static constexpr auto update_opts = make_options({
+    { "log", true, 'l' },
+    { "log-format", true },
+    { "dir", true, 'd' },
+    { "filter", true, 'f' },
+    { "extension", true, 'x' },
+    { "yes", false, 'y' },
+    { "code", false, 'c' },
+    { "profile", true },
+    { "metrics", true }
+});
+
+static constexpr auto search_opts = make_options({
+    { "tier", true, 't' },
+    { "local", false, 'l' },
+    { "missing", false, 'm' },
+    { "dir", true, 'd' },
+    { "limit", true, 'n' },
+    { "sync", false },
+    { "profile", true }
+});
+
+static constexpr auto next_opts = make_options({
+    { "tier", true, 't' },
+    { "count", true, 'n' },
+    { "dir", true, 'd' },
+    { "profile", true }
+});
+
+static constexpr auto history_opts = make_options({
+    { "since", true, 's' },
+    { "until", true, 'u' },
+    { "monthly", false, 'm' },
+    { "dir", true, 'd' }
+});
+
+static constexpr auto test_opts = make_options({
+    { "jobs", true, 'j' },
+    { "timeout", true },
+    { "dir", true, 'd' },
+    { "profile", true }
+});
+
+static constexpr auto bench_opts = make_options({
+    { "runs", true, 'n' },
+    { "warmup", true, 'w' },
+    { "cpu", true },
+    { "timeout", true },
+    { "dir", true, 'd' },
+    { "profile", true }
+});
+
+static constexpr auto fsck_opts = make_options({
+    { "fix", false, 'f' },
+    { "yes", false, 'y' },
+    { "dir", true, 'd' },
+    { "profile", true }
+});
+
+static constexpr auto daemon_opts = make_options({
+    { "socket", true, 's' }
+});
+
+static_assert(
+    search_opts.error == table_error_t::none && next_opts.error == table_error_t::none && history_opts.error == table_error_t::none &&
+    test_opts.error == table_error_t::none && bench_opts.error == table_error_t::none && fsck_opts.error == table_error_t::none &&
+    daemon_opts.error == table_error_t::none &&
+    info_opts.error == table_error_t::none && patch_opts.error == table_error_t::none && get_opts.error == table_error_t::none &&
+    new_opts.error == table_error_t::none && update_opts.error == table_error_t::none
+);
+
+void info(const args& arg);
+void patch(const args& arg);
+void get(const args& arg);
+void new_file(const args& arg);
+void update(const args& arg);
+void search(const args& arg);
+void next_cmd(const args& arg);
+void history(const args& arg);
+void test_cmd(const args& arg);
+void bench_cmd(const args& arg);
+void fsck(const args& arg);
+void daemon_cmd(const args& arg);
+
+struct command_t {
+    std::string_view name;
+    std::string_view desc;
+    std::string_view help;
+    opt_view opts;
+    // nullptr prints help.
+    void (*run)(const args&);
 };
 
-static std::unordered_map<std::string, i32> tables {
-    { "help", 0 },
-    { "info", 1 },
-    { "patch", 2 },
-    { "get", 3 },
-    { "new", 4 },
-    { "update", 5 }
+// In the order they are listed by 'help'.
+static constexpr command_t commands[] = {
+    { "info", "Gets tier information in current/specific directory.", info_help, info_opts, info },
+    { "patch", "Updates tier and moves files to the correct directory.", patch_help, patch_opts, patch },
+    { "get", "Gets tier information with problem id", get_help, get_opts, get },
+    { "new", "Create new file with tier", new_help, new_opts, new_file },
+    { "update", "Updates source code that are solved but not in the directory.", update_help, update_opts, update },
+    { "search", "Searches cached problem titles offline.", search_help, search_opts, search },
+    { "next", "Suggests unsolved problems to practice.", next_help, next_opts, next_cmd },
+    { "history", "Shows level changes applied by patch.", history_help, history_opts, history },
+    { "test", "Compiles solutions and runs their sample tests.", test_help, test_opts, test_cmd },
+    { "bench", "Times a solution on its sample inputs.", bench_help, bench_opts, bench_cmd },
+    { "fsck", "Finds duplicate and misplaced solutions.", fsck_help, fsck_opts, fsck },
+    { "daemon", "Serves info, get and new from a background process.", daemon_help, daemon_opts, daemon_cmd },
+    { "help", "Show help", "", help_opts, nullptr }
 };
 
-inline std::string rgb_color(int r, int g, int b) {
-#ifndef ANSI_ENABLED
-    return "";
-#endif
-    std::stringstream ss;
-    ss << "\033[38;2;" << r << ";" << g << ";" << b << "m";
+// Perfect hash over the command names, case insensitive on the first and
+// last letter; the static_assert below keeps it collision free.
+static constexpr u32 command_hash(std::string_view s)
+{ return s.empty() ? 0 : ((s[0] | 0x20) + (s.back() | 0x20) * 8 + s.size()) & 31; }
+
+static constexpr std::array<i8, 32> command_slots = [] {
+    std::array<i8, 32> t { };
+    for (auto& x : t) x = -1;
+
+    for (i32 i = 0; i < (i32)std::size(commands); i++) {
+        auto& x = t[command_hash(commands[i].name)];
+        x = x == -1 ? i : -2;
+    }
+
+    return t;
+}();
+
+static_assert([] {
+    for (auto x : command_slots) if (x == -2) return false;
+    return true;
+}(), "command_hash has a collision");
+
+// Command named s, ignoring case, or nullptr.
+static const command_t* find_command(std::string_view s) {
+    i8 i = command_slots[command_hash(s)];
+    if (i < 0) return nullptr;
+
+    std::string_view n = commands[i].name;
+    if (n.size() != s.size()) return nullptr;
 
-    return ss.str();
+    for (std::size_t k = 0; k < n.size(); k++)
+        if (std::tolower((unsigned char)s[k]) != n[k]) return nullptr;
+
+    return commands + i;
 }
 
-template <typename _Clock, typename _Duration>
-inline std::ostream& operator<<(std::ostream& __os, std::chrono::time_point<_Clock, _Duration> tp) {
-    std::time_t t = _Clock::to_time_t(tp);
-    
-    return __os << std::put_time(localtime(&t), "%c %Z");
+log_sink::format get_log_format(const args& arg, std::string_view c);
+
+// Thrown by quit() while the daemon runs a forwarded command, where
+// exit() would take the daemon down along with the request.
+struct quit_t { i32 code; };
+
+static bool _serving = false;
+
+[[noreturn]] static void quit(i32 code) {
+    if (_serving) throw quit_t { code };
+
+    // In order, before anything at exit can get in the way.
+    bout.flush();
+    berr.flush();
+    exit(code);
 }
 
 void help(
-    const args& arg, const std::string& c,
-    bool err = false, const std::string& s = ""
+    const args& arg, std::string_view c,
+    bool err = false, std::string_view s = ""
 ) {
-    auto& out = err ? std::cerr : std::cout;
+    writer_t& out = err ? berr : bout;
 
     if (c == "help") {
+        const command_t* cmd = arg.args.empty() ? nullptr : find_command(arg.args[0]);
+
         if (err)
             out << COLORED_ERROR ": " << s << "\n";
         else if (arg.args.empty())
             out <<
                 "Baekjoon source code manager with solved.ac tier.\n";
-        else if (!opt_table.count(arg.args[0]))
+        else if (!cmd)
             out << COLORED_ERROR ": Unknown command '" << arg.args[0] << "'.\n";
         else
-            out << "\n" << help_table[arg.args[0]];
+            out << "\n" << cmd->help;
         
-        if (arg.args.empty() || !opt_table.count(arg.args[0])) {
+        if (!cmd) {
             out <<
                 ""                                                 "\n"
                 COLORED_USAGE ": " APP_NAME " <command> [options]" "\n"
                 ""                                                 "\n"
                 COLORED_MENU("Command List")                       "\n";
             
-            for (auto& [s1, s2] : short_desc)
-                out << "  " << std::left << std::setw(6) << s1 << " : " << s2 << "\n";
+            for (auto& x : commands) {
+                out << "  ";
+                out.pad_right(x.name, 6) << " : " << x.desc << "\n";
+            }
             
             out <<
                 ""                                                                              "\n"
@@ -231,645 +520,861 @@ void help(
     } else {
         if (err)
             out << COLORED_ERROR ": " << s << "\n";
-        out << "\n" << help_table[c];
+        if (auto cmd = find_command(c)) out << "\n" << cmd->help;
     }
 }
 
-void rec(std::vector<std::vector<i32>>& ps, const fs::path& p) {
-    if (fs::is_directory(p)) {
-        for (const auto& e : fs::directory_iterator(p)) rec(ps, e.path());
-    } else if (p.extension() == ".cpp") {
-        int n = std::stoi(p.stem());
-        ps[(int)tier_t(p.parent_path().filename())].push_back(n);
+log_sink::format get_log_format(const args& arg, std::string_view c) {
+    log_sink::format f = log_sink::format::text;
+
+    if (arg.options.count("log-format")) {
+        std::string s(*arg.options.at("log-format").value);
+
+        if (!log_sink::parse_format(s, f)) {
+            help(arg, c, true, "Invalid log format '" + s + "'");
+            quit(1);
+        }
     }
+
+    return f;
 }
 
-void get_list(std::vector<std::vector<i32>>& ps, fs::path __p) {
-    for (const auto& folder : { "Bronze", "Silver", "Gold", "Platinum", "Diamond", "Ruby" }) {
-        fs::path p = __p / folder;
-        rec(ps, p);
-    }
+// Process-wide solved.ac client. A daemon keeps it, and with it the
+// connection and the problem cache, across forwarded commands that use the
+// same BJMGR_API_URL.
+static client_t& api() {
+    static std::unique_ptr<client_t> c;
+
+    if (std::string url = client_t::default_api_url(); !c || c->api_url() != url)
+        c = std::make_unique<client_t>(std::move(url));
 
-    for (auto& v : ps) std::sort(v.begin(), v.end());
+    return *c;
 }
 
-void info(const args& arg) {
-    std::cout << "\n";
+// Keep fetched titles for 'search'. The catalog is only rewritten when
+// something in it changed.
+static void remember(const std::vector<problem_t>& ps) {
+    PROF_SCOPE("catalog");
+    catalog_t::merge(catalog_t::default_path(), ps);
+}
 
-    fs::path dir = arg.options.count("dir") ? fs::path(arg.options.at("dir").value.value()) : fs::path(".");
+fs::path get_dir(const args& arg) {
+    return arg.options.count("dir") ? fs::path(*arg.options.at("dir").value) : fs::path(".");
+}
 
-    if (!fs::exists(dir)) {
-        help(
-            arg, "info", true,
-            "'" + dir.string() + "': No such directory"
-        ); exit(1);
-    }
+inventory_t get_list(const args& arg, std::string_view c) {
+    auto inv = bjmgr::scan(get_dir(arg));
 
-    if (!fs::is_directory(dir)) {
-        help(
-            arg, "info", true,
-            "'" + dir.string() + "': Not a directory"
-        ); exit(1);
+    if (!inv.ok()) {
+        help(arg, c, true, inv.error().message);
+        quit(1);
     }
 
-    std::vector<std::vector<i32>> ps(32);
-    get_list(ps, dir);
+    return std::move(inv.value());
+}
 
-    i32 c = 0;
-    std::stringstream ss;
+static void print_levels(const std::vector<std::vector<i32>>& ps, u32 mask, const std::vector<std::vector<u32>>* langs = nullptr) {
+    std::size_t c = 0;
 
-    tier_range rng;
-    
-    if (arg.options.count("search")) {
-        const std::string& st = arg.options.at("search").value.value();
-        rng = tier_range(st);
+    for (u32 m = mask; m; m &= m - 1) c += ps[__builtin_ctz(m)].size();
 
-        if (!rng.valid) {
-            help(arg, "info", true, "Invalid tier range '" + st + "'");
-            exit(1);
+    bout << COLORED_TEXT(210, "Total Count") " : " << c << "\n";
+
+    // Problems per language, from the masks the scan already read. A
+    // problem with both "cc" and "cpp" files counts once for C++.
+    if (langs) {
+        std::vector<std::pair<std::string_view, std::size_t>> by_name;
+
+        for (u32 m = mask; m; m &= m - 1) {
+            for (u32 x : (*langs)[__builtin_ctz(m)]) {
+                std::string_view seen[lang::count];
+                i32 ns = 0;
+
+                for (; x; x &= x - 1) {
+                    auto name = lang::table[__builtin_ctz(x)].name;
+                    if (std::find(seen, seen + ns, name) != seen + ns) continue;
+                    seen[ns++] = name;
+
+                    auto it = std::find_if(by_name.begin(), by_name.end(), [&] (auto& e) { return e.first == name; });
+                    if (it == by_name.end()) by_name.emplace_back(name, 1);
+                    else it->second++;
+                }
+            }
+        }
+
+        std::stable_sort(by_name.begin(), by_name.end(), [] (auto& a, auto& b) { return a.second > b.second; });
+
+        if (!by_name.empty()) {
+            bout << COLORED_TEXT(210, "Languages") "   : ";
+
+            for (std::size_t i = 0; i < by_name.size(); i++)
+                bout << (i ? ", " : "") << by_name[i].first << ' ' << by_name[i].second;
+
+            bout << "\n";
         }
     }
 
-    i32 s = (i32)rng.start, e = (i32)rng.end;
+    bout << "\n";
 
-    for (i32 i = s; i <= e; i++) {
+    for (u32 m = mask; m; m &= m - 1) {
+        i32 i = __builtin_ctz(m);
         if (ps[i].empty()) continue;
-        auto [r, g, b] = tier_t(i).color();
-        ss
-            << rgb_color(r, g, b)
-            << tier_t(i).long_name() << RESET " : " << ps[i].size() << "\n";
+        tier_t t(i);
+        bout << t.ansi() << t.long_name() << RESET " : " << ps[i].size() << "\n";
 
         i32 k = 0;
 
-        c += ps[i].size();
         for (auto x : ps[i]) {
-            if (k % 16 == 0) ss << "    ";
-            ss << std::setw(5) << x << " ";
+            if (k % 16 == 0) bout << "    ";
+            bout.num(x, 5) << ' ';
             k++;
-            if (k % 16 == 0) ss << "\n";
+            if (k % 16 == 0) bout << '\n';
         }
 
-        if (k % 16) ss << "\n";
+        if (k % 16) bout << '\n';
     }
-
-    std::cout << COLORED_TEXT(210, "Total Count") " : " << c << "\n\n" << ss.str();
 }
 
-static size_t WriteCallback(void *contents, size_t size, size_t nmemb, void *userp)
-{
-    ((std::string*)userp)->append((char*)contents, size * nmemb);
-    return size * nmemb;
-}
-
-void patch(const args& arg) {
-    std::cout << "\n";
-    
-    fs::path f_log = arg.options.count("log") ? fs::path(arg.options.at("log").value.value()) : fs::path("log.txt");
+// Bitset over catalog indices.
+using bits_t = std::vector<u64>;
 
-    if (fs::exists(f_log) && !arg.options.count("yes")) {
-        std::cout << "'" << f_log.string() << "': File already exists. Overwrite? [y/N] ";
+static bool test(const bits_t& b, u32 i) { return b[i >> 6] >> (i & 63) & 1; }
 
-        i32 r = getch(true);
-        std::cout << std::endl;
+// info --tag/--histogram/--crosstab. The workspace problems become a
+// bitset over the catalog, and every tag query is an intersection of it
+// with the tags' posting lists.
+static void tag_info(const args& arg, const std::vector<std::vector<i32>>& ps, const tier_range& rng) {
+    catalog_t cat;
 
-        if (r != 'y' && r != 'Y') {
-            std::cout << "\nPatch canceled by user.\n";
-            exit(1);
-        }
+    if (!cat.tag_count()) {
+        berr << COLORED_ERROR ": No problem tags cached yet. Run '" APP_NAME " search --sync' first.\n";
+        quit(1);
     }
 
-    std::ofstream lgout(f_log);
+    PROF_SCOPE("tags");
 
-    lgout << std::chrono::system_clock::now() << "\n\n";
+    // Workspace level of each catalog problem, 0 if it is not selected.
+    std::vector<u8> lv(cat.size(), 0);
+    bits_t sel((cat.size() + 63) / 64, 0);
+    std::size_t unknown = 0;
 
-    fs::path dir = arg.options.count("dir") ? fs::path(arg.options.at("dir").value.value()) : fs::path(".");
-    std::vector<std::vector<i32>> ps(32);
-    std::vector<std::pair<i32, tier_t>> odat;
-    std::map<i32, tier_t> ndat;
-    get_list(ps, dir);
+    for (u32 m = rng.mask & ~1u; m; m &= m - 1) {
+        i32 t = __builtin_ctz(m);
 
-    for (i32 i = 1; i <= 30; i++) {
-        for (auto x : ps[i]) {
-            odat.emplace_back(x, tier_t(i));
+        for (auto x : ps[t]) {
+            i32 k = cat.find(x);
+            if (k < 0) { unknown++; continue; }
+
+            lv[k] = t;
+            sel[k >> 6] |= 1ull << (k & 63);
         }
     }
 
-    sort(odat.begin(), odat.end(), [] (const auto& a, const auto& b) {
-        bool r = a.second < b.second;
-        if (a.second == b.second) r = a.first < b.first;
-        return r;
-    });
+    if (arg.options.count("tag")) {
+        std::string st(*arg.options.at("tag").value);
+        bits_t b(sel.size());
 
-    const auto url = BASE_URL "problem/lookup?problemIds=";
-    CURL* curl = curl_easy_init();
+        strlib::split_views(st, ',', [&] (std::string_view key) {
+            bool deny = !key.empty() && key[0] == '!';
+            if (deny) key.remove_prefix(1);
 
-    if (curl) {
-        std::cout << "Fetching data from solved.ac... 0%" << std::flush;
-    
-        std::string buf;
-
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &buf);
-
-        for (i32 i = 0; i < (i32)odat.size(); i += 100) {
-            std::string s = url +
-            strlib::join(
-                odat.begin() + i,
-                odat.begin() + std::min(i + 100, (i32)odat.size()),
-                [] (const auto& p) { return std::to_string(p.first); },
-                ","
-            );
-            curl_easy_setopt(curl, CURLOPT_URL, s.c_str());
-
-            CURLcode req = curl_easy_perform(curl);
-
-            if (req != CURLE_OK) {
-                std::cerr << COLORED_ERROR ": " << curl_easy_strerror(req);
-                exit(1);
-            }
+            i32 t = cat.find_tag(key);
 
-            long sc; curl_easy_getinfo(curl, CURLINFO_HTTP_CODE, &sc);
-
-            if (sc != 200) {
-                std::cerr <<
-                    COLORED_ERROR ": Error while fetching data\n"
-                    "Check your network connection or try again later.\n\n"
-                    "Check log file for more information.\n";
-                
-                lgout <<
-                    "/* Debug Informations */" "\n"
-                    "HTTP Status Code : " << sc << "\n"
-                    "Response : \n" << buf << "\n"
-                    "/* End of Debug Informations */" "\n";
-                exit(1);
+            if (t < 0) {
+                help(arg, "info", true, "Unknown tag '" + std::string(key) + "'");
+                quit(1);
             }
 
-            auto res = json::parse(buf);
-
-            for (auto& it : res) {
-                auto pid = it["problemId"].get<i32>();
-                auto lv = tier_t(it["level"].get<i32>());
-                ndat[pid] = lv;
-                auto [_r, _g, _b] = lv.color();
-                lgout <<
-                    "Data fetched : " << pid <<
-                    " => " << rgb_color(_r, _g, _b) <<
-                    lv.long_name() << RESET << "\n";
-            }
+            std::fill(b.begin(), b.end(), 0);
+            for (u32 i : cat.tagged(t)) b[i >> 6] |= 1ull << (i & 63);
+
+            for (std::size_t w = 0; w < sel.size(); w++) sel[w] &= deny ? ~b[w] : b[w];
+        });
+    }
 
-            lgout.flush();
+    u64 total = 0;
+    for (u64 w : sel) total += __builtin_popcountll(w);
 
-            buf.clear();
+    if (!arg.options.count("histogram") && !arg.options.count("crosstab")) {
+        std::vector<std::vector<i32>> out(32);
 
-            std::cout << "\rFetching data from solved.ac... " << (i32)(i * 1.L / odat.size() * 100) << "%" << std::flush;
-        }
+        for (std::size_t w = 0; w < sel.size(); w++)
+            for (u64 m = sel[w]; m; m &= m - 1) {
+                u32 i = w * 64 + __builtin_ctzll(m);
+                out[lv[i]].push_back(cat.at(i).id);
+            }
 
-        curl_easy_cleanup(curl);
+        print_levels(out, rng.mask);
     } else {
-        std::cerr << COLORED_ERROR ": Error while initializing CURL\n";
-        exit(1);
-    }
+        bool cross = arg.options.count("crosstab");
 
-    std::cout << "\rFetching data from solved.ac... Done.\n" << std::flush;
+        // Per tag: problems in each tier group (Bronze..Ruby) and in all.
+        struct row_t { u32 tag; u32 n[7]; };
+        std::vector<row_t> rows;
+        std::size_t width = 3;
 
-    std::vector<std::tuple<i32, tier_t, tier_t>> diff;
+        for (u32 t = 0; t < cat.tag_count(); t++) {
+            row_t r { t, { } };
 
-    for (auto [id, t] : odat) {
-        if (t != ndat[id]) {
-            diff.emplace_back(id, t, ndat[id]);
+            for (u32 i : cat.tagged(t))
+                if (test(sel, i)) { r.n[(lv[i] - 1) / 5]++; r.n[6]++; }
 
-            auto [_or, _og, _ob] = t.color();
-            auto [_nr, _ng, _nb] = ndat[id].color();
+            if (!r.n[6]) continue;
 
-            lgout <<
-                "Diff : " << id << " : " <<
-                rgb_color(_or, _og, _ob) <<
-                t.long_name() << RESET " <-> " <<
-                rgb_color(_nr, _ng, _nb) <<
-                ndat[id].long_name() << RESET << "\n";
+            rows.push_back(r);
+            width = std::max(width, cat.tag(t).size());
         }
-    }
 
-    lgout.flush();
+        std::sort(rows.begin(), rows.end(), [&] (const row_t& a, const row_t& b) {
+            return a.n[6] != b.n[6] ? a.n[6] > b.n[6] : a.tag < b.tag;
+        });
 
-    if (diff.empty()) {
-        std::cout << "Nothing to patch.\n";
-        return;
-    }
+        bout << COLORED_TEXT(210, "Total Count") " : " << total << "\n\n";
 
-    std::vector<std::string> diff_str;
-    for (auto& [n, ot, nt] : diff) {
-        auto [_or, _og, _ob] = ot.color();
-        auto [_nr, _ng, _nb] = nt.color();
-
-        std::stringstream ss;
-        ss
-            << n << " : "
-            << rgb_color(_or, _og, _ob)
-            << ot.long_name() << RESET " -> "
-            << rgb_color(_nr, _ng, _nb)
-            << nt.long_name() << RESET;
-        
-        diff_str.push_back(ss.str());
-    }
+        if (cross) {
+            bout << "  ";
+            bout.pad_right("tag", width);
 
-    if (!arg.options.count("yes")) {
-        std::cout << "Do you want to view patch list? [y/N] ";
+            for (i32 g = 0; g < 6; g++) {
+                tier_t t(g * 5 + 1);
+                bout << "  " << t.ansi();
+                bout.pad_right(t.long_name().substr(0, t.long_name().find(' ')), 8) << RESET;
+            }
 
-        i32 r = getch(true);
-        std::cout << std::endl;
+            bout << "   Total\n";
+        }
 
-        if (r == 'y' || r == 'Y') {
-            fs::path tmp = fs::temp_directory_path() / "bjmgr_patch_list.txt";
-            std::ofstream out(tmp);
-            
-            for (auto& s : diff_str) out << s << "\n";
-            out.close();
+        u32 top = rows.empty() ? 1 : rows[0].n[6];
 
-            [[maybe_unused]]
-            int _r = system(("less " + tmp.string()).c_str());
+        for (auto& r : rows) {
+            bout << "  ";
+            bout.pad_right(cat.tag(r.tag), width);
 
-            fs::remove(tmp);
+            if (cross) {
+                for (i32 g = 0; g < 6; g++) { bout << "  "; bout.num(r.n[g], 8); }
+                bout << "  ";
+                bout.num(r.n[6], 6) << "\n";
+            } else {
+                bout << "  ";
+                bout.num(r.n[6], 6) << "  ";
+                bout.pad_right("", (r.n[6] * 40 + top - 1) / top, '#') << "\n";
+            }
         }
     }
 
-    if (!arg.options.count("yes")) {
-        std::cout << "Proceed to patch? [y/N] ";
+    if (unknown)
+        bout << "\n" << unknown << " problems are not in the catalog yet and were left out.\n";
+}
 
-        i32 r = getch(true);
-        std::cout << std::endl;
+// info --stats: file totals per tier and per extension.
+static void stats_info(const args& arg, const tier_range& rng) {
+    auto res = bjmgr::stats(get_dir(arg));
 
-        if (r != 'y' && r != 'Y') {
-            std::cout << "\nPatch canceled by user.\n";
-            exit(1);
-        }
+    if (!res.ok()) {
+        help(arg, "info", true, res.error().message);
+        quit(1);
     }
 
-    std::cout << "Patching files... 0%" << std::flush;
+    auto& by_level = res.value();
 
-    i32 err_cnt = 0;
-    for (i32 i = 0; i < (i32)diff.size(); i++) {
-        auto [id, o, n] = diff[i];
+    std::map<std::string, file_stats_t> by_ext;
+    file_stats_t total;
 
-        if (!n.valid()) {
-            lgout << "[" COLORED_ERROR "] Cannot patch as the tier is invalid or Unrated (" << id << ")\n";
-            continue;
-        }
+    auto add = [] (file_stats_t& a, const file_stats_t& b) {
+        a.files += b.files; a.stubs += b.stubs; a.lines += b.lines; a.bytes += b.bytes;
+    };
 
-        auto str = std::to_string(id) + ".cpp";
-        fs::path
-            op = dir / fs::path(o.path()) / str,
-            np = dir / fs::path(n.path()) / str;
-        
-        if (!fs::exists(np.parent_path())) {
-            fs::create_directories(np.parent_path());
-        }
+    auto row = [] (std::string_view name, std::string_view color, const file_stats_t& s) {
+        bout << "  " << color;
+        bout.pad_right(name, 12);
+        if (!color.empty()) bout << RESET;
+        bout.num(s.files, 8);
+        bout.num(s.stubs, 8);
+        bout.num(s.lines, 11);
+        bout.num(s.bytes, 13) << "\n";
+    };
 
-        std::error_code err;
-        fs::rename(op, np, err);
-        if (err) {
-            err_cnt++;
-            lgout << "[" COLORED_ERROR "] Patching Failed (" << id << ") : " << err.message() << "\n";
-        } else
-            lgout << "Patching Success (" << id << ")\n";
-        std::cout << "\rPatching files... " << (i32)(i * 1.L / diff.size() * 100) << "%" << std::flush;
-    }
+    auto header = [] (std::string_view name) {
+        bout << "  ";
+        bout.pad_right(name, 12) << "   Files   Stubs      Lines        Bytes\n";
+    };
 
-    std::cout
-        << "\rPatching files... Done.\n\n"
-        << "Total : " << diff.size() << ", Success : " << diff.size() - err_cnt << ", Error : " << err_cnt << "\n";
-    
-    if (err_cnt)
-        std::cout << "For each issue that occurred with the problem id, please refer to the log file.\n";
-}
+    for (u32 m = rng.mask; m; m &= m - 1)
+        for (auto& [ext, s] : by_level[__builtin_ctz(m)]) { add(by_ext[ext], s); add(total, s); }
 
-problem_t get_problem(int n) {
-    CURL* curl = curl_easy_init();
-    std::string buf;
-    
-    if (curl) {
-        auto url = BASE_URL "problem/show?problemId=" + std::to_string(n);
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &buf);
-        
-        CURLcode req = curl_easy_perform(curl);
-        
-        if (req != CURLE_OK) {
-            std::cerr << COLORED_ERROR ": " << curl_easy_strerror(req);
-            exit(2);
-        }
-        
-        long sc; curl_easy_getinfo(curl, CURLINFO_HTTP_CODE, &sc);
-        curl_off_t rt; curl_easy_getinfo(curl, CURLINFO_RETRY_AFTER, &rt);
-        
-        if (sc == 400) { help(args(), "get", true, "Bad Request"); exit(1); }
-        if (sc == 404) { std:: cerr << "\n" << buf << " | Problem Number : " << n; exit(4); }
-        if (sc == 429) { std:: cerr << "\n" << buf << " | Wait for sec : "; printf("%" CURL_FORMAT_CURL_OFF_T "s", rt); }
-        if (sc != 200) { std:: cerr << "\n" << buf; exit(1); }
-        
-        curl_easy_cleanup(curl);
-        
-        auto res = json::parse(buf);
+    bout << COLORED_TEXT(210, "Total Count") " : " << total.files << "\n\n";
 
-        problem_t p;
+    header("Tier");
 
-        p.name = res["titleKo"].get<std::string>();
-        p.url = "https://www.acmicpc.net/problem/" + std::to_string(n);
-        p.id = n;
-        p.tier = tier_t(res["level"].get<int>());
-        
-        return p;
-    } else { std::cerr << COLORED_ERROR ": CURL INIT ERROR"; exit(-1); }
-}
+    for (u32 m = rng.mask; m; m &= m - 1) {
+        i32 i = __builtin_ctz(m);
+        if (by_level[i].empty()) continue;
 
-void get(const args& arg) {
-    if (arg.args.empty()) {
-        help(arg, "get", true, "Missing problem id");
-        exit(1);
-    }
+        file_stats_t s;
+        for (auto& [ext, x] : by_level[i]) add(s, x);
 
-    int n;
-    if (!strlib::try_parse(n, arg.args[0])) {
-        help(arg, "get", true, "Invalid problem id");
-        exit(1);
+        tier_t t(i);
+        row(t.long_name(), t.ansi(), s);
     }
-    auto p = get_problem(n);
-    
-    auto [r, g, b] = p.tier.color();
-
-    std::cout << "\n" <<
-        "[" << rgb_color(r, g, b) << p.tier.long_name() << RESET "] " <<
-        p.name << "\nLink : " << p.url << "\n";
-}
 
-void new_file(const args& arg) {
-    if (arg.args.empty()) {
-        help(arg, "new", true, "Missing problem id");
-        exit(1);
-    }
+    bout << "\n";
+    header("Extension");
 
-    int n;
-    if (!strlib::try_parse(n, arg.args[0])) {
-        help(arg, "new", true, "Invalid problem id");
-        exit(1);
-    }
-    tier_t t = arg.options.count("tier") ? tier_t(*arg.options.at("tier").value) : get_problem(n).tier;
+    for (auto& [ext, s] : by_ext) row(ext, "", s);
 
-    std::string fext = arg.options.count("extension") ? *arg.options.at("extension").value : "cpp";
-    fs::path dir = arg.options.count("dir") ? fs::path(*arg.options.at("dir").value) : fs::path(".");
-    fs::path p(dir / t.path() / (std::to_string(n) + "." + fext));
+    bout << "\n";
+    row("Total", "", total);
+}
 
-    // 추가: 부모 디렉터리가 없으면 생성 (Bronze/Bronze 5 등)
-    if (!fs::exists(p.parent_path())) {
-        fs::create_directories(p.parent_path());
-    }
+void info(const args& arg) {
+    bout << "\n";
 
-    std::cout << "\n";
+    tier_range rng;
+    
+    if (arg.options.count("search")) {
+        std::string st(*arg.options.at("search").value);
+        rng = tier_range(st);
 
-    if (fs::exists(p) && !arg.options.count("yes")) {
-        std::cout << "'" << p.string() << "': File already exists. Overwrite? [y/N] ";
+        if (!rng.valid) {
+            help(arg, "info", true, "Invalid tier range '" + st + "'");
+            quit(1);
+        }
+    }
 
-        i32 r = getch(true);
-        std::cout << std::endl;
+    bool tags = arg.options.count("tag") || arg.options.count("histogram") || arg.options.count("crosstab");
 
-        if (r != 'y' && r != 'Y') {
-            std::cout << "\nCanceled by user.\n";
-            exit(1);
+    if (arg.options.count("stats")) {
+        if (tags) {
+            help(arg, "info", true, "--stats does not combine with tag options");
+            quit(1);
         }
+
+        return stats_info(arg, rng);
     }
 
-    std::ofstream(p).close();
+    auto inv = get_list(arg, "info");
 
-    std::cout << "File created. : " << p.string() << "\n";
+    if (tags) return tag_info(arg, inv.levels, rng);
 
-    if (arg.options.count("code"))
-        [[maybe_unused]]
-        int _r = system(("code -r \'" + p.string() + "'").c_str());
-    else
-        std::cout << "Open file with 'code -r " << p.string() << "'\n";
+    print_levels(inv.levels, rng.mask, &inv.langs);
 }
 
-void update(const args& arg) {
-    std::cout << "\n";
+// Report a failed patch/update fetch and quit.
+[[noreturn]] static void fetch_failed(log_sink& lg, const failure_t& e) {
+    if (e.kind == failure_t::network) {
+        berr << COLORED_ERROR ": " << e.message;
+    } else if (e.kind == failure_t::parse) {
+        berr << COLORED_ERROR ": Error while parsing data\n";
+        lg.push({ log_phase::fetch, log_result::fail, 0, -1, -1, e.message + "\nResponse : \n" + e.body });
+    } else {
+        berr <<
+            COLORED_ERROR ": Error while fetching data\n"
+            "Check your network connection or try again later.\n\n"
+            "Check log file for more information.\n";
 
-    if (arg.args.empty()) {
-        help(arg, "list", true, "Missing username");
-        exit(1);
+        lg.push({ log_phase::fetch, log_result::fail, 0, -1, -1, e.message + "\nResponse : \n" + e.body });
     }
+
+    quit(1);
+}
+
+void patch(const args& arg) {
+    bout << "\n";
     
-    fs::path f_log = arg.options.count("log") ? fs::path(arg.options.at("log").value.value()) : fs::path("log.txt");
+    fs::path f_log = arg.options.count("log") ? fs::path(*arg.options.at("log").value) : fs::path("log.txt");
 
     if (fs::exists(f_log) && !arg.options.count("yes")) {
-        std::cout << "'" << f_log.string() << "': File already exists. Overwrite? [y/N] ";
+        bout << "'" << f_log.string() << "': File already exists. Overwrite? [y/N] ";
 
         i32 r = getch(true);
-        std::cout << std::endl;
+        bout << "\n";
 
         if (r != 'y' && r != 'Y') {
-            std::cout << "\nPatch canceled by user.\n";
-            exit(1);
+            bout << "\nPatch canceled by user.\n";
+            quit(1);
         }
     }
 
-    tier_range rng;
+    log_sink lg(f_log, get_log_format(arg, "patch"));
 
-    if (arg.options.count("filter")) {
-        const std::string& st = arg.options.at("filter").value.value();
-        rng = tier_range(st);
+    lg.push({ log_phase::run, log_result::ok, 0, -1, -1, "patch" });
 
-        if (!rng.valid) {
-            help(arg, "update", true, "Invalid tier range '" + st + "'");
-            exit(1);
-        }
-    }
+    fs::path dir = get_dir(arg);
+    inventory_t inv = get_list(arg, "patch");
+    metrics::tier_counts(inv.levels);
 
-    std::ofstream lgout(f_log);
+    std::vector<i32> ids;
+    for (auto r : inv.records()) ids.push_back(r.id());
 
-    lgout << std::chrono::system_clock::now() << "\n\n";
+    std::vector<problem_t> cur;
 
-    fs::path dir = arg.options.count("dir") ? fs::path(arg.options.at("dir").value.value()) : fs::path(".");
-    std::vector<std::vector<i32>> ps(32);
-    std::vector<std::pair<i32, tier_t>> odat;
-    std::map<i32, tier_t> ndat;
-    get_list(ps, dir);
+    {
+        metrics_phase _mp("fetch");
+        progress_t prog("Fetching data from solved.ac", ids.size());
 
-    for (i32 i = 1; i <= 30; i++) {
-        for (auto x : ps[i]) {
-            odat.emplace_back(x, tier_t(i));
-        }
-    }
+        auto res = api().lookup(ids, [&] (const std::vector<problem_t>& b, std::size_t) { prog.add(b.size()); }).get();
+        if (!res.ok()) fetch_failed(lg, res.error());
 
-    sort(odat.begin(), odat.end(), [] (const auto& a, const auto& b) {
-        bool r = a.second < b.second;
-        if (a.second == b.second) r = a.first < b.first;
-        return r;
-    });
+        cur = std::move(res.value());
+        for (auto& p : cur) lg.push({ log_phase::fetch, log_result::ok, p.id, -1, (i32)p.tier });
 
-    const auto url = BASE_URL "search/problem?query=s@" + arg.args[0];
-    CURL* curl = curl_easy_init();
+        remember(cur);
 
-    if (curl) {
-        std::cout << "Fetching data from solved.ac... 0%" << std::flush;
-    
-        std::string buf;
+        prog.finish();
+    }
 
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &buf);
+    std::vector<move_t> diff;
 
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        CURLcode req = curl_easy_perform(curl);
+    {
+        metrics_phase _mp("diff");
+        diff = bjmgr::plan_patch(inv, cur);
 
-        if (req != CURLE_OK) {
-            std::cerr << COLORED_ERROR ": " << curl_easy_strerror(req);
-            exit(1);
-        }
+        for (auto& m : diff) lg.push({ log_phase::diff, log_result::ok, m.id, (i32)m.from, (i32)m.to });
+    }
 
-        long sc; curl_easy_getinfo(curl, CURLINFO_HTTP_CODE, &sc);
+    metrics::diffs(diff.size());
 
-        if (sc != 200) {
-            std::cerr <<
-                COLORED_ERROR ": Error while fetching data\n"
-                "Check your network connection or try again later.\n\n"
-                "Check log file for more information.\n";
-                
-            lgout <<
-                "/* Debug Informations */" "\n"
-                "HTTP Status Code : " << sc << "\n"
-                "Response : \n" << buf << "\n"
-                "/* End of Debug Informations */" "\n";
-            exit(1);
-        }
+    if (diff.empty()) {
+        bout << "Nothing to patch.\n";
+        metrics::success();
+        return;
+    }
 
-        auto _res = json::parse(buf);
+    std::vector<std::string> diff_str;
+    for (auto& m : diff) {
+        std::string s = std::to_string(m.id) + " : ";
+        s += m.from.ansi(); s += m.from.long_name(); s += RESET " -> ";
+        s += m.to.ansi(); s += m.to.long_name(); s += RESET;
+        diff_str.push_back(std::move(s));
+    }
 
-        i32 size = _res["count"].get<i32>();
+    if (!arg.options.count("yes")) {
+        bout << "Do you want to view patch list? [y/N] ";
 
-        for (i32 i = 0, len = size / 50 + !!(size % 50); i < len; i++) {
-            std::string s = url + "&page=" + std::to_string(i + 1);
-            curl_easy_setopt(curl, CURLOPT_URL, s.c_str());
+        i32 r = getch(true);
+        bout << "\n";
 
-            buf = "";
+        if (r == 'y' || r == 'Y') {
+            fs::path tmp = fs::temp_directory_path() / "bjmgr_patch_list.txt";
+            std::ofstream out(tmp);
+            
+            for (auto& s : diff_str) out << s << "\n";
+            out.close();
 
-            CURLcode req = curl_easy_perform(curl);
+            bout.flush();
 
-            if (req != CURLE_OK) {
-                std::cerr << COLORED_ERROR ": " << curl_easy_strerror(req);
-                exit(1);
-            }
+            [[maybe_unused]]
+            int _r = system(("less " + tmp.string()).c_str());
 
-            long sc; curl_easy_getinfo(curl, CURLINFO_HTTP_CODE, &sc);
-
-            if (sc != 200) {
-                std::cerr <<
-                    COLORED_ERROR ": Error while fetching data\n"
-                    "Check your network connection or try again later.\n\n"
-                    "Check log file for more information.\n";
-                
-                lgout <<
-                    "/* Debug Informations */" "\n"
-                    "HTTP Status Code : " << sc << "\n"
-                    "Response : \n" << buf << "\n"
-                    "/* End of Debug Informations */" "\n";
-                exit(1);
-            }
+            fs::remove(tmp);
+        }
+    }
 
-            nlohmann::json res;
-
-            try {
-                res = json::parse(buf);
-            } catch (...) {
-                std::cerr << COLORED_ERROR "Error while parsing data\n";
-                lgout <<
-                    "/* Debug Informations */" "\n"
-                    "Response : \n" << buf << "\n"
-                    "/* End of Debug Informations */" "\n";
-                exit(1);
-            }
+    if (!arg.options.count("yes")) {
+        bout << "Proceed to patch? [y/N] ";
 
+        i32 r = getch(true);
+        bout << "\n";
 
-            for (auto& it : res["items"]) {
-                auto pid = it["problemId"].get<i32>();
-                auto lv = tier_t(it["level"].get<i32>());
-                ndat[pid] = lv;
-                auto [_r, _g, _b] = lv.color();
-                lgout <<
-                    "Data fetched : " << pid <<
-                    " => " << rgb_color(_r, _g, _b) <<
-                    lv.long_name() << RESET << "\n";
-            }
+        if (r != 'y' && r != 'Y') {
+            bout << "\nPatch canceled by user.\n";
+            quit(1);
+        }
+    }
 
-            lgout.flush();
+    metrics_phase _mp("apply");
+    progress_t prog("Patching files", diff.size());
 
-            buf.clear();
+    i32 err_cnt = 0;
 
-            std::cout << "\rFetching data from solved.ac... " << (i32)(i * 1.L / len * 100) << "%" << std::flush;
+    std::vector<move_t> moved;
+
+    bjmgr::apply_patch(dir, diff, [&] (const applied_t& a) {
+        auto& m = a.move;
+
+        switch (a.outcome) {
+            case applied_t::moved:
+                moved.push_back(m);
+                lg.push({ log_phase::patch, log_result::ok, m.id, (i32)m.from, (i32)m.to });
+                break;
+            case applied_t::skipped:
+                lg.push({ log_phase::patch, log_result::invalid, m.id, (i32)m.from, (i32)m.to });
+                break;
+            case applied_t::failed:
+                err_cnt++;
+                lg.push({ log_phase::patch, log_result::fail, m.id, (i32)m.from, (i32)m.to, a.message });
+                break;
         }
 
-        curl_easy_cleanup(curl);
-    } else {
-        std::cerr << COLORED_ERROR ": Error while initializing CURL\n";
-        exit(1);
-    }
+        prog.add();
+    });
 
-    std::cout << "\rFetching data from solved.ac... Done.\n" << std::flush;
+    prog.finish();
 
-    i32 cnts = 0;
-    std::unordered_set<i32> s;
-    std::map<i32, tier_t> filt;
+    // Unlike the log, the history outlives this run.
+    if (!history_t::append(history_t::path_for(dir), std::time(nullptr), std::move(moved)))
+        berr << COLORED_ERROR ": Could not append to '" << history_t::path_for(dir).string() << "'\n";
 
-    for (auto [id, t] : odat)
-        s.insert(id);
+    bout
+        << "\n"
+        << "Total : " << diff.size() << ", Success : " << diff.size() - err_cnt << ", Error : " << err_cnt << "\n";
     
-    for (auto [id, t] : ndat) {
-        auto [_r, _g, _b] = t.color();
-
-        lgout << "[" << rgb_color(_r, _g, _b) << t.long_name() << RESET "] " << id << " : ";
+    if (err_cnt)
+        bout << "For each issue that occurred with the problem id, please refer to the log file.\n";
 
-        if (s.count(id))
-            lgout << COLOR(46) "✔" RESET "\n";
-        else {
-            cnts++;
+    metrics::success();
+}
 
-            if (rng.contains(t))
-                filt[id] = t;
+// Report a failed problem fetch. Returns the exit status it calls for:
+// 2 when solved.ac is unreachable, 4 for an unknown problem, else 1.
+static i32 fetch_problem_failed(const args& arg, std::string_view c, i32 n, const failure_t& e) {
+    switch (e.kind) {
+        case failure_t::network:
+            berr << COLORED_ERROR ": " << e.message << "\n";
+            return 2;
+        case failure_t::parse:
+            berr << COLORED_ERROR ": Error while parsing data\n" << e.body << "\n";
+            return 1;
+        default:
+            break;
+    }
+
+    if (e.status == 400) { help(arg, c, true, "Bad Request"); return 1; }
+    if (e.status == 404) { berr << COLORED_ERROR ": Problem " << n << " not found\n"; return 4; }
+    if (e.status == 429) { berr << "\n" << e.body << " | Wait for sec : "; berr << e.retry_after << "s"; }
+
+    berr << "\n" << e.body << "\n";
+    return 1;
+}
+
+// get and new read problem ids from the input when given none, or "-".
+static bool ids_from_input(const args& arg) {
+    return arg.args.empty() || (arg.args.size() == 1 && arg.args[0] == "-");
+}
+
+// Run f for every problem id of the command, in input order, as soon as it
+// and every id before it are resolved. Ids come from the arguments or are
+// streamed from the input, separated by whitespace or commas; all of them
+// are requested up front, so the client sends them as a few lookups.
+// Without fetch only the id is filled in. Returns the exit status for the
+// ids that failed.
+static i32 each_problem(
+    const args& arg, std::string_view c, bool fetch,
+    const std::function<void(const problem_t&)>& f
+) {
+    struct slot_t { i32 id; std::future<result_t<problem_t>> p; };
+
+    std::deque<slot_t> q;
+    i32 status = 0;
+
+    auto push = [&] (std::string_view s) {
+        i32 n;
+
+        if (!strlib::try_parse(n, std::string(s)) || n <= 0) {
+            berr << COLORED_ERROR ": Invalid problem id '" << s << "'\n";
+            status = std::max(status, 1);
+            return;
+        }
+
+        q.push_back({ n, fetch ? api().problem(n) : std::future<result_t<problem_t>>() });
+    };
+
+    // Hand the resolved head of q to f; everything when wait.
+    auto drain = [&] (bool wait) {
+        for (; !q.empty(); q.pop_front()) {
+            auto& x = q.front();
+
+            if (!fetch) {
+                problem_t p;
+                p.id = x.id;
+                f(p);
+                continue;
+            }
+
+            if (!wait && x.p.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+
+            auto r = x.p.get();
+
+            if (r.ok()) f(r.value());
+            else {
+                i32 e = fetch_problem_failed(arg, c, x.id, r.error());
+
+                // Every other request would fail the same way.
+                if (e == 2) quit(2);
+                status = std::max(status, e);
+            }
+        }
+    };
+
+    if (!ids_from_input(arg)) {
+        for (auto s : arg.args) {
+            i32 n;
+
+            if (!strlib::try_parse(n, std::string(s)) || n <= 0) {
+                help(arg, c, true, "Invalid problem id '" + std::string(s) + "'");
+                quit(1);
+            }
+        }
+
+        for (auto s : arg.args) push(s);
+        drain(true);
+
+        return status;
+    }
+
+    int fd = input_fd();
+
+    if (arg.args.empty() && isatty(fd)) {
+        help(arg, c, true, "Missing problem id");
+        quit(1);
+    }
+
+    std::string tok;
+    char buf[4096];
+
+    for (bool eof = false; !eof; ) {
+        pollfd pfd { fd, POLLIN, 0 };
+
+        // While the writer is idle, keep printing what has arrived.
+        i32 pr = poll(&pfd, 1, q.empty() ? -1 : 5);
+        if (pr < 0 && errno == EINTR) continue;
+        if (pr == 0) { drain(false); bout.flush(); continue; }
+
+        ssize_t r = pr < 0 ? -1 : ::read(fd, buf, sizeof(buf));
+        if (r < 0 && errno == EINTR) continue;
+
+        // The ids read so far are still answered, but a cut-off input is
+        // not a clean end.
+        if (r < 0) {
+            berr << COLORED_ERROR ": Cannot read the input: " << std::strerror(errno) << "\n";
+            status = 1;
+        }
+
+        if (r <= 0) eof = true;
+
+        for (ssize_t i = 0; i < r; i++) {
+            if (std::isspace((unsigned char)buf[i]) || buf[i] == ',') {
+                if (!tok.empty()) push(tok);
+                tok.clear();
+            } else
+                tok += buf[i];
+        }
+
+        drain(false);
+        bout.flush();
+    }
+
+    if (!tok.empty()) push(tok);
+    drain(true);
+
+    return status;
+}
+
+void get(const args& arg) {
+    std::vector<problem_t> seen;
+
+    i32 st = each_problem(arg, "get", true, [&] (const problem_t& p) {
+        bout
+            << "\n[" << p.tier.ansi() << p.tier.long_name() << RESET "] "
+            << p.name << "\nLink : " << p.url << "\n";
+
+        seen.push_back(p);
+    });
+
+    remember(seen);
+
+    if (st) quit(st);
+}
+
+void new_file(const args& arg) {
+    bool forced = arg.options.count("tier");
+    tier_t ft = forced ? tier_t(*arg.options.at("tier").value) : tier_t();
+
+    std::string_view fext = arg.options.count("extension") ? *arg.options.at("extension").value : "cpp";
+    fs::path dir = get_dir(arg), last;
+
+    bool ask = !arg.options.count("yes"), code = arg.options.count("code");
+    // Ids on the input leave nobody to answer an overwrite prompt.
+    bool piped = ids_from_input(arg);
+    i32 made = 0, failed = 0;
+    std::vector<problem_t> seen;
+
+    bout << "\n";
+
+    i32 st = each_problem(arg, "new", !forced, [&] (const problem_t& pr) {
+        if (!forced) seen.push_back(pr);
+
+        fs::path p = bjmgr::solution_path(dir, pr.id, forced ? ft : pr.tier, fext);
+        // --yes or a confirmed prompt, the only ways to clear a file.
+        bool overwrite = !ask;
+
+        if (fs::exists(p) && ask) {
+            if (piped) {
+                bout << "'" << p.string() << "': File already exists. Skipped.\n";
+                return;
+            }
 
-            lgout << COLOR(160) "✘" RESET "\n";
+            bout << "'" << p.string() << "': File already exists. Overwrite? [y/N] ";
+
+            i32 r = getch(true);
+            bout << "\n";
+
+            if (r != 'y' && r != 'Y') {
+                if (arg.args.size() > 1) { bout << "Skipped.\n"; return; }
+
+                bout << "\nCanceled by user.\n";
+                quit(1);
+            }
+
+            overwrite = true;
+        }
+
+        if (auto e = bjmgr::create(p, overwrite)) {
+            berr << COLORED_ERROR ": " << e.message << "\n";
+            failed++;
+            return;
+        }
+
+        bout << "File created. : " << p.string() << "\n";
+        made++;
+        last = p;
+
+        if (code) {
+            bout.flush();
+
+            [[maybe_unused]]
+            int _r = system(("code -r \'" + p.string() + "'").c_str());
+        }
+    });
+
+    if (made == 1 && !code)
+        bout << "Open file with 'code -r " << last.string() << "'\n";
+
+    remember(seen);
+
+    if (st || failed) quit(st ? st : 1);
+}
+
+void update(const args& arg) {
+    bout << "\n";
+
+    if (arg.args.empty()) {
+        help(arg, "list", true, "Missing username");
+        quit(1);
+    }
+    
+    fs::path f_log = arg.options.count("log") ? fs::path(*arg.options.at("log").value) : fs::path("log.txt");
+
+    if (fs::exists(f_log) && !arg.options.count("yes")) {
+        bout << "'" << f_log.string() << "': File already exists. Overwrite? [y/N] ";
+
+        i32 r = getch(true);
+        bout << "\n";
+
+        if (r != 'y' && r != 'Y') {
+            bout << "\nPatch canceled by user.\n";
+            quit(1);
         }
     }
 
-    lgout.flush();
+    // Unrated problems have no level folder to go to.
+    tier_range rng;
+    rng.mask = tier_range::rated;
+
+    if (arg.options.count("filter")) {
+        std::string st(*arg.options.at("filter").value);
+        rng = tier_range(st);
+
+        if (!rng.valid) {
+            help(arg, "update", true, "Invalid tier range '" + st + "'");
+            quit(1);
+        }
+    }
+
+    log_sink lg(f_log, get_log_format(arg, "update"));
+
+    lg.push({ log_phase::run, log_result::ok, 0, -1, -1, "update" });
+
+    fs::path dir = get_dir(arg);
+    inventory_t inv = get_list(arg, "update");
+    metrics::tier_counts(inv.levels);
+
+    std::vector<problem_t> solved;
+
+    {
+        metrics_phase _mp("fetch");
+        progress_t prog("Fetching data from solved.ac");
+
+        auto res = api().solved(std::string(arg.args[0]), [&] (const std::vector<problem_t>& b, std::size_t total) {
+            prog.set_total(total);
+            prog.add(b.size());
+        }).get();
+
+        if (!res.ok()) fetch_failed(lg, res.error());
 
-    std::cout
+        solved = std::move(res.value());
+        for (auto& p : solved) lg.push({ log_phase::fetch, log_result::ok, p.id, -1, (i32)p.tier });
+
+        remember(solved);
+
+        prog.finish();
+    }
+
+    std::vector<check_t> checks;
+    i32 cnts = 0;
+    std::size_t cached = inv.records().size();
+    std::vector<std::pair<i32, tier_t>> filt;
+
+    {
+        metrics_phase _mp("diff");
+        checks = bjmgr::plan_update(inv, std::move(solved), rng);
+
+        for (auto& c : checks) {
+            auto& p = c.problem;
+
+            if (c.present)
+                lg.push({ log_phase::check, log_result::present, p.id, -1, (i32)p.tier });
+            else {
+                cnts++;
+
+                if (c.selected)
+                    filt.emplace_back(p.id, p.tier);
+
+                lg.push({ log_phase::check, log_result::missing, p.id, -1, (i32)p.tier });
+            }
+        }
+    }
+
+    bout
         << "\n[" COLORED_TEXT(219, "Result") "]\n"
-        << COLORED_TEXT(46, "Solved") " : " << ndat.size() << "\n"
-        << COLORED_TEXT(45, "Cached") " : " << odat.size() << "\n"
+        << COLORED_TEXT(46, "Solved") " : " << checks.size() << "\n"
+        << COLORED_TEXT(45, "Cached") " : " << cached << "\n"
         << COLORED_TEXT(208, "Not in directory") " : " << cnts << "\n"
         << COLORED_TEXT(27, "Filtered") " : " << filt.size() << "\n\n";
     
     if (filt.size() == 0) {
-        std::cout << "Nothing to update.\n";
+        bout << "Nothing to update.\n";
+        metrics::success();
         return;
     }
 
     if (!arg.options.count("yes")) {
-        std::cout << "Do you want to view update list? [y/N] ";
+        bout << "Do you want to view update list? [y/N] ";
 
         i32 r = getch(true);
-        std::cout << std::endl;
+        bout << "\n";
 
         if (r == 'y' || r == 'Y') {
             fs::path tmp = fs::temp_directory_path() / "bjmgr_update_list.txt";
             std::ofstream out(tmp);
             
             for (auto& [id, t] : filt) {
-                auto [_r, _g, _b] = t.color();
-                out << id << " : " << rgb_color(_r, _g, _b) << t.long_name() << RESET << "\n";
+                out << id << " : " << t.ansi() << t.long_name() << RESET << "\n";
             }
             out.close();
 
+            bout.flush();
+
             [[maybe_unused]]
             int _r = system(("less " + tmp.string()).c_str());
 
@@ -878,51 +1383,58 @@ void update(const args& arg) {
     }
 
     if (!arg.options.count("yes")) {
-        std::cout << "Proceed to update? [y/N] ";
+        bout << "Proceed to update? [y/N] ";
 
         i32 r = getch(true);
-        std::cout << std::endl;
+        bout << "\n";
 
         if (r != 'y' && r != 'Y') {
-            std::cout << "\nupdate canceled by user.\n";
-            exit(1);
+            bout << "\nupdate canceled by user.\n";
+            quit(1);
         }
     }
 
-    std::cout << "\n";
+    bout << "\n";
 
-    std::string fext = arg.options.count("extension") ? *arg.options.at("extension").value : "cpp";
+    std::string_view fext = arg.options.count("extension") ? *arg.options.at("extension").value : "cpp";
 
     i32 i = 1;
+    metrics_phase _mp("apply");
 
     for (auto& [id, t] : filt) {
-        std::cout << "\rupdating files... " << i << " / " << filt.size() << std::flush;
-        fs::path p(dir / t.path() / (std::to_string(id) + "." + fext));
+        bout << "\rupdating files... " << i << " / " << filt.size();
+        fs::path p = bjmgr::solution_path(dir, id, t, fext);
 
-        std::ofstream(p).close();
+        if (auto e = bjmgr::create(p))
+            lg.push({ log_phase::create, log_result::fail, id, -1, (i32)t, e.message });
+        else
+            lg.push({ log_phase::create, log_result::ok, id, -1, (i32)t, p.string() });
 
-        lgout << "File created : " << p.string() << "\n";
+        if (arg.options.count("code")) {
+            bout.flush();
 
-        if (arg.options.count("code"))
             [[maybe_unused]]
             int _r = system(("code -r \'" + p.string() + "'").c_str());
+        }
 
-        std::cout << " [ next(n), skip(s), quit(q) ]" << std::flush;
+        bout << " [ next(n), skip(s), quit(q) ]";
         
         while (true) {
             i32 _inp = getch(false);
         
             switch (_inp) {
                 case 'n': case 'N':
+                    metrics::created();
                     break;
                 case 's': case 'S':
-                    lgout << "File skipped : " << p.string() << "\n";
+                    lg.push({ log_phase::create, log_result::skip, id, -1, (i32)t, p.string() });
                     fs::remove(p);
                     break;
                 case 'q': case 'Q':
-                    lgout << "Update canceled by user.\n";
-                    std::cout << "\n\nUpdate canceled by user.\n";
-                    lgout.flush();
+                    lg.push({ log_phase::run, log_result::cancel, 0, -1, -1, "Update canceled by user." });
+                    bout << "\n\nUpdate canceled by user.\n";
+                    metrics::created();
+                    metrics::success();
                     return;
                 default:
                     continue;
@@ -934,36 +1446,1001 @@ void update(const args& arg) {
         i++;
     }
 
-    std::cout << "\r" << std::string(60, ' ') << std::flush;
-    std::cout << "\rupdating files... Done.\n\n";
+    bout << '\r';
+    bout.fill(' ', 60);
+    bout << "\rupdating files... Done.\n\n";
+
+    metrics::success();
 }
 
-int main(int argc, char** argv) {
-    std::cout << COLORED_APP_NAME " " APP_VERSION "\n";
+// Look every problem up on solved.ac and store the titles in the catalog:
+// blocks of 1000 ids from 1000 on, until two blocks in a row come back
+// empty.
+static void sync_catalog(const args& arg, const fs::path& cp) {
+    std::vector<problem_t> all;
+
+    {
+        progress_t prog("Fetching problem titles from solved.ac");
+
+        for (i32 b = 1000, empty = 0; empty < 2; b += 1000) {
+            std::vector<i32> ids(1000);
+            for (i32 i = 0; i < 1000; i++) ids[i] = b + i;
+
+            auto r = api().lookup(std::move(ids), [&] (const std::vector<problem_t>& batch, std::size_t) {
+                prog.add(batch.size());
+            }).get();
+
+            if (!r.ok()) quit(fetch_problem_failed(arg, "search", 0, r.error()));
+
+            empty = r->empty() ? empty + 1 : 0;
+            all.insert(all.end(), std::make_move_iterator(r->begin()), std::make_move_iterator(r->end()));
+        }
+
+        prog.finish();
+    }
+
+    PROF_SCOPE("catalog");
+
+    if (!catalog_t::merge(cp, all)) {
+        berr << COLORED_ERROR ": '" << cp.string() << "': Cannot write the catalog\n";
+        quit(1);
+    }
+
+    bout << "Cached " << all.size() << " problems in " << cp.string() << "\n";
+}
+
+void search(const args& arg) {
+    bout << "\n";
+
+    fs::path cp = catalog_t::default_path();
+    bool sync = arg.options.count("sync");
+
+    if (sync) sync_catalog(arg, cp);
+
+    std::string text;
+    strlib::append_join(text, arg.args.begin(), arg.args.end(), " ");
+
+    if (text.empty()) {
+        if (sync) return;
+
+        help(arg, "search", true, "Missing search text");
+        quit(1);
+    }
+
+    tier_range rng;
+
+    if (arg.options.count("tier")) {
+        std::string st(*arg.options.at("tier").value);
+        rng = tier_range(st);
+
+        if (!rng.valid) {
+            help(arg, "search", true, "Invalid tier range '" + st + "'");
+            quit(1);
+        }
+    }
+
+    bool local = arg.options.count("local"), missing = arg.options.count("missing");
+
+    if (local && missing) {
+        help(arg, "search", true, "--local and --missing exclude each other");
+        quit(1);
+    }
+
+    i32 limit = 50;
+
+    if (arg.options.count("limit") && (!strlib::try_parse(limit, std::string(*arg.options.at("limit").value)) || limit < 0)) {
+        help(arg, "search", true, "Invalid limit '" + std::string(*arg.options.at("limit").value) + "'");
+        quit(1);
+    }
+
+    catalog_t cat(cp);
+
+    if (cat.empty()) {
+        berr << COLORED_ERROR ": No problem titles cached yet. Run '" APP_NAME " search --sync' first.\n";
+        quit(1);
+    }
+
+    std::vector<u32> hits;
+
+    {
+        PROF_SCOPE("search");
+        hits = cat.search(text);
+    }
+
+    std::vector<i32> have;
+
+    if (local || missing) {
+        for (auto r : get_list(arg, "search").records()) have.push_back(r.id());
+        std::sort(have.begin(), have.end());
+    }
+
+    std::vector<catalog_t::entry_t> res;
+
+    for (u32 i : hits) {
+        auto e = cat.at(i);
+
+        if (!rng.contains(e.tier)) continue;
+        if ((local || missing) && std::binary_search(have.begin(), have.end(), e.id) != local) continue;
+
+        res.push_back(e);
+    }
+
+    bout << COLORED_TEXT(210, "Found") " : " << res.size() << "\n\n";
+
+    std::size_t shown = limit ? std::min<std::size_t>(limit, res.size()) : res.size();
+
+    for (std::size_t i = 0; i < shown; i++) {
+        auto& e = res[i];
+
+        bout << "  ";
+        bout.num(e.id, 5) << " [" << e.tier.ansi() << e.tier.long_name() << RESET "] " << e.title << "\n";
+    }
+
+    if (shown < res.size())
+        bout << "  ... " << res.size() - shown << " more (see --limit)\n";
+}
+
+void next_cmd(const args& arg) {
+    bout << "\n";
+
+    tier_range rng;
+
+    if (arg.options.count("tier")) {
+        std::string st(*arg.options.at("tier").value);
+        rng = tier_range(st);
+
+        if (!rng.valid) {
+            help(arg, "next", true, "Invalid tier range '" + st + "'");
+            quit(1);
+        }
+    }
+
+    i32 count = 10;
+
+    if (arg.options.count("count") && (!strlib::try_parse(count, std::string(*arg.options.at("count").value)) || count <= 0)) {
+        help(arg, "next", true, "Invalid count '" + std::string(*arg.options.at("count").value) + "'");
+        quit(1);
+    }
+
+    catalog_t cat;
+
+    if (cat.empty()) {
+        berr << COLORED_ERROR ": No problems cached yet. Run '" APP_NAME " search --sync' first.\n";
+        quit(1);
+    }
+
+    auto records = get_list(arg, "next").records();
+
+    PROF_SCOPE("rank");
+
+    const u32 n = cat.size();
+    const u8* lv = cat.levels();
+    const u32* sv = cat.solvers();
+
+    // Workspace problems by catalog index, as 0/1 so they can be scaled.
+    std::vector<f32> have(n, 0.f);
+    f32 hist[32] = { };
+    u32 known = 0;
+
+    for (auto r : records) {
+        hist[r.tier().code]++;
+
+        if (i32 k = cat.find(r.id()); k >= 0) { have[k] = 1.f; known++; }
+    }
+
+    // An empty directory starts at Bronze III.
+    if (records.empty()) hist[3] = 1;
+
+    // Level fit: the directory's level histogram smoothed over 1.5 levels
+    // and shifted one level up, so the best fit sits just above what is
+    // usually solved. Unrated levels and those outside --tier score far
+    // below anything else, which keeps the loop below free of branches.
+    f32 fit[32] = { }, peak = 0;
+
+    for (i32 l = 1; l <= 30; l++) {
+        for (i32 m = 1; m <= 30; m++) fit[l] += hist[m] * std::exp(-(f32)((l - m - 1) * (l - m - 1)) / 4.5f);
+        peak = std::max(peak, fit[l]);
+    }
+
+    for (i32 l = 0; l < 32; l++)
+        fit[l] = l >= 1 && l <= 30 && rng.contains(tier_t(l)) ? fit[l] / peak : -1e9f;
+
+    // Tag gaps: how far each tag's share of the directory falls below its
+    // share of the catalog. A problem takes the largest gap of its tags.
+    std::vector<f32> gap(n, 0.f);
+
+    for (u32 t = 0; t < cat.tag_count(); t++) {
+        auto list = cat.tagged(t);
+        f32 expected = (f32)list.size() * known / n, c = 0;
+
+        if (expected < 1) continue;
+
+        for (u32 i : list) c += have[i];
+
+        f32 g = std::max(0.f, 1 - c / expected);
+        for (u32 i : list) gap[i] = std::max(gap[i], g);
+    }
+
+    u32 top = 0;
+    for (u32 i = 0; i < n; i++) top = std::max(top, sv[i]);
+
+    const f32 pop = top ? 1.f / top : 0.f;
+
+    // One pass over the columns; solved problems sink like unrated ones.
+    std::vector<f32> score(n);
+
+    for (u32 i = 0; i < n; i++)
+        score[i] = 0.5f * fit[lv[i]] + 0.3f * gap[i] + 0.2f * std::sqrt(sv[i] * pop) - 1e9f * have[i];
+
+    // Top count by a bounded min-heap.
+    using cand_t = std::pair<f32, u32>;
+    std::vector<cand_t> best;
+    auto worse = [] (const cand_t& a, const cand_t& b) { return a.first > b.first || (a.first == b.first && a.second < b.second); };
+
+    for (u32 i = 0; i < n; i++) {
+        if (score[i] < -1e8f) continue;
+
+        if (best.size() < (std::size_t)count) {
+            best.emplace_back(score[i], i);
+            std::push_heap(best.begin(), best.end(), worse);
+        } else if (worse({ score[i], i }, best.front())) {
+            std::pop_heap(best.begin(), best.end(), worse);
+            best.back() = { score[i], i };
+            std::push_heap(best.begin(), best.end(), worse);
+        }
+    }
+
+    std::sort_heap(best.begin(), best.end(), worse);
+
+    bout << COLORED_TEXT(210, "Suggested") " : " << best.size() << "\n\n";
+
+    for (auto& [sc, i] : best) {
+        auto e = cat.at(i);
+
+        bout << "  ";
+        bout.num(e.id, 5) << " [" << e.tier.ansi() << e.tier.long_name() << RESET "] " << e.title << "\n";
+
+        std::string tags;
+
+        for (u32 t = 0; t < cat.tag_count(); t++) {
+            auto list = cat.tagged(t);
+            if (!std::binary_search(list.begin(), list.end(), i)) continue;
+
+            if (!tags.empty()) tags += ", ";
+            tags += cat.tag(t);
+        }
+
+        bout << "          ";
+        if (!tags.empty()) bout << tags << ", ";
+        bout << e.solvers << " solvers\n";
+    }
+}
+
+// Local midnight of "YYYY-MM-DD" or the first of "YYYY-MM", or -1.
+static i64 parse_date(const std::string& s) {
+    std::tm tm { };
+    // Where the match ended, to reject anything left after it.
+    i32 end = -1;
+
+    if (std::sscanf(s.c_str(), "%d-%d-%d%n", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &end) != 3 || end != (i32)s.size()) {
+        end = -1;
+        tm.tm_mday = 1;
+
+        if (std::sscanf(s.c_str(), "%d-%d%n", &tm.tm_year, &tm.tm_mon, &end) != 2 || end != (i32)s.size()) return -1;
+    }
+
+    if (tm.tm_mon < 1 || tm.tm_mon > 12 || tm.tm_mday < 1 || tm.tm_mday > 31) return -1;
+
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    tm.tm_isdst = -1;
+
+    return std::mktime(&tm);
+}
+
+void history(const args& arg) {
+    bout << "\n";
+
+    i64 since = 0, until = INT64_MAX;
+
+    for (auto [name, dest] : { std::pair { "since", &since }, std::pair { "until", &until } }) {
+        if (!arg.options.count(name)) continue;
+
+        std::string st(*arg.options.at(name).value);
+        *dest = parse_date(st);
+
+        if (*dest < 0) {
+            help(arg, "history", true, "Invalid date '" + st + "'");
+            quit(1);
+        }
+    }
+
+    std::vector<i32> ids;
+
+    for (auto& a : arg.args) {
+        i32 n;
+
+        if (!strlib::try_parse(n, std::string(a)) || n <= 0) {
+            help(arg, "history", true, "Invalid problem id '" + std::string(a) + "'");
+            quit(1);
+        }
+
+        ids.push_back(n);
+    }
+
+    std::sort(ids.begin(), ids.end());
+
+    fs::path hp = history_t::path_for(get_dir(arg));
+    history_t h(hp);
+
+    if (h.empty()) {
+        bout << "No level changes recorded in '" << hp.string() << "' yet.\n";
+        return;
+    }
+
+    std::vector<history_t::change_t> cs;
+
+    {
+        PROF_SCOPE("history");
+        cs = h.range(since, until, ids);
+    }
+
+    auto stamp = [] (i64 ts, const char* fmt) {
+        char buf[32];
+        std::time_t t = ts;
+        std::strftime(buf, sizeof(buf), fmt, std::localtime(&t));
+        return std::string(buf);
+    };
+
+    bout << COLORED_TEXT(210, "Changes") " : " << cs.size() << "\n";
+
+    if (arg.options.count("monthly")) {
+        bout << "\n";
+
+        // Changes of one run share a stamp, so each run is formatted once.
+        std::vector<std::pair<std::string, std::pair<std::size_t, std::size_t>>> months;
+        i64 last = -1;
+        std::string month;
+
+        for (auto& c : cs) {
+            if (c.ts != last) month = stamp(last = c.ts, "%Y-%m");
+            if (months.empty() || months.back().first != month) months.push_back({ month, { 0, 0 } });
+
+            auto& [up, down] = months.back().second;
+            (c.to.code > c.from.code ? up : down)++;
+        }
+
+        for (auto& [m, n] : months) {
+            bout << "  " << m << " : ";
+            bout.num(n.first + n.second, 5) << "  (up " << n.first << ", down " << n.second << ")\n";
+        }
+
+        return;
+    }
+
+    for (std::size_t i = 0; i < cs.size(); i++) {
+        if (!i || cs[i].ts != cs[i - 1].ts) bout << "\n" << stamp(cs[i].ts, "%Y-%m-%d %H:%M") << "\n";
+
+        auto& c = cs[i];
+
+        bout << "  ";
+        bout.num(c.id, 5) << " : "
+            << c.from.ansi() << c.from.long_name() << RESET " -> "
+            << c.to.ansi() << c.to.long_name() << RESET "\n";
+    }
+}
+
+// Integer option name of c into dest, if given; at least min.
+static void int_option(const args& arg, std::string_view c, const char* name, i32 min, i32& dest) {
+    if (!arg.options.count(name)) return;
+
+    std::string st(*arg.options.at(name).value);
+
+    if (!strlib::try_parse(dest, st) || dest < min) {
+        help(arg, c, true, "Invalid " + std::string(name) + " '" + st + "'");
+        quit(1);
+    }
+}
+
+// --timeout into opts, and a check that the compiler runs at all.
+static void judge_options(const args& arg, std::string_view c, judge::options_t& opts) {
+    i32 ms = opts.timeout_ms;
+    int_option(arg, c, "timeout", 1, ms);
+    opts.timeout_ms = ms;
+
+    if (judge::compiler_version(opts).empty()) {
+        berr << COLORED_ERROR ": Cannot run the compiler '" << opts.cxx << "'. Set CXX to a C++ compiler.\n";
+        quit(1);
+    }
+}
+
+// First lines of a compiler's output, indented under a result line.
+static void print_log(const std::string& log) {
+    std::size_t pos = 0;
+
+    // The first errors are usually the ones that matter.
+    for (i32 k = 0; k < 10 && pos < log.size(); k++) {
+        std::size_t nl = log.find('\n', pos);
+        bout << "          " << std::string_view(log).substr(pos, nl - pos) << "\n";
+        pos = nl == std::string::npos ? log.size() : nl + 1;
+    }
+}
+
+void test_cmd(const args& arg) {
+    bout << "\n";
+
+    std::vector<i32> ids;
+    u32 mask = 0;
+
+    for (auto& a : arg.args) {
+        i32 n;
+
+        if (strlib::try_parse(n, std::string(a))) {
+            if (n <= 0) {
+                help(arg, "test", true, "Invalid problem id '" + std::string(a) + "'");
+                quit(1);
+            }
+
+            ids.push_back(n);
+            continue;
+        }
+
+        tier_range r(a);
+
+        if (!r.valid) {
+            help(arg, "test", true, "Invalid problem id or tier range '" + std::string(a) + "'");
+            quit(1);
+        }
+
+        mask |= r.mask;
+    }
+
+    if (ids.empty() && !mask) mask = tier_range::rated;
+    std::sort(ids.begin(), ids.end());
+
+    auto opts = judge::default_options();
+
+    int_option(arg, "test", "jobs", 1, opts.jobs);
+
+    judge_options(arg, "test", opts);
+
+    auto inv = get_list(arg, "test");
+
+    std::vector<judge::target_t> ts;
+    std::vector<i32> found;
+
+    for (i32 i = 1; i <= 30; i++) {
+        for (std::size_t k = 0; k < inv.levels[i].size(); k++) {
+            i32 id = inv.levels[i][k];
+            bool named = std::binary_search(ids.begin(), ids.end(), id);
+
+            if (named) found.push_back(id);
+            if (named || (mask >> i & 1)) ts.push_back({ id, tier_t(i), inv.langs[i][k] });
+        }
+    }
+
+    std::sort(found.begin(), found.end());
+
+    for (i32 id : ids)
+        if (!std::binary_search(found.begin(), found.end(), id))
+            berr << COLORED_ERROR ": " << id << " is not in the directory.\n";
+
+    if (ts.empty()) {
+        bout << "Nothing to test.\n";
+        return;
+    }
+
+    progress_t prog("Testing", ts.size());
+    auto reps = judge::run(get_dir(arg), ts, opts, [&] (const judge::report_t&) { prog.add(); });
+    prog.finish();
+
+    bout << "\n";
+
+    static constexpr std::string_view verdicts[] = { "ok", "wrong answer", "runtime error", "time limit" };
+    std::size_t passed = 0, failed = 0, untested = 0, built = 0;
+
+    for (auto& r : reps) {
+        auto& t = r.target;
+
+        bout << "  ";
+        bout.num(t.id, 5) << " [" << t.tier.ansi() << t.tier.long_name() << RESET "] ";
+
+        if (r.build == judge::report_t::no_source) {
+            bout << "no C++ solution\n";
+            untested++;
+            continue;
+        }
+
+        if (r.build == judge::report_t::failed) {
+            bout << COLORED_TEXT(160, "compile error") "\n";
+            failed++;
+            print_log(r.log);
+            continue;
+        }
+
+        built += r.build == judge::report_t::built;
+
+        std::size_t ok = std::count_if(r.cases.begin(), r.cases.end(), [] (auto& c) { return c.verdict == judge::case_t::pass; });
+
+        if (r.cases.empty()) {
+            bout << "no samples\n";
+            untested++;
+            continue;
+        }
+
+        bout << ok << "/" << r.cases.size() << " passed\n";
+        (ok == r.cases.size() ? passed : failed)++;
+
+        for (auto& c : r.cases) {
+            if (c.verdict == judge::case_t::pass) continue;
+
+            bout << "          " << c.name << " : " << verdicts[c.verdict] << " (" << c.ms << " ms)\n";
+
+            if (c.verdict == judge::case_t::wrong)
+                bout << "            expected : " << c.expected << "\n"
+                     << "            got      : " << c.got << "\n";
+        }
+    }
+
+    bout
+        << "\n"
+        << "Total : " << reps.size() << ", Passed : " << passed << ", Failed : " << failed
+        << ", Untested : " << untested << ", Compiled : " << built << "\n";
+
+    if (failed) quit(1);
+}
+
+// "12.34 ms" for us microseconds.
+static std::string ms_str(i64 us) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.2f ms", us / 1e3);
+    return buf;
+}
+
+// "1.23M" for n.
+static std::string count_str(i64 n) {
+    char buf[32];
+
+    if (n >= 1000000000) std::snprintf(buf, sizeof(buf), "%.2fG", n / 1e9);
+    else if (n >= 1000000) std::snprintf(buf, sizeof(buf), "%.2fM", n / 1e6);
+    else if (n >= 1000) std::snprintf(buf, sizeof(buf), "%.1fK", n / 1e3);
+    else std::snprintf(buf, sizeof(buf), "%lld", (long long)n);
+
+    return buf;
+}
+
+// "3.4 MiB" for kb KiB.
+static std::string mib_str(i64 kb) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.1f MiB", kb / 1024.0);
+    return buf;
+}
+
+// Change from before to now, as "+4.1%".
+static std::string delta_str(i64 before, i64 now) {
+    if (before <= 0) return "-";
+
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%+.1f%%", (now - before) * 100.0 / before);
+    return buf;
+}
+
+void bench_cmd(const args& arg) {
+    bout << "\n";
+
+    i32 id;
+
+    if (arg.args.size() != 1 || !strlib::try_parse(id, std::string(arg.args[0])) || id <= 0) {
+        help(arg, "bench", true, arg.args.size() != 1 ? "One problem id expected" : "Invalid problem id '" + std::string(arg.args[0]) + "'");
+        quit(1);
+    }
+
+    judge::bench_options_t bopts;
+    bopts.cpu = judge::default_cpu();
+
+    int_option(arg, "bench", "runs", 1, bopts.runs);
+    int_option(arg, "bench", "warmup", 0, bopts.warmup);
+    int_option(arg, "bench", "cpu", 0, bopts.cpu);
+
+    if (arg.options.count("cpu") && !judge::cpu_allowed(bopts.cpu)) {
+        help(arg, "bench", true, "CPU " + std::to_string(bopts.cpu) + " is not available");
+        quit(1);
+    }
+
+    auto opts = judge::default_options();
+    judge_options(arg, "bench", opts);
+
+    auto inv = get_list(arg, "bench");
+    judge::target_t t { id, tier_t(), 0 };
+
+    for (i32 i = 1; i <= 30 && !t.langs; i++) {
+        auto& v = inv.levels[i];
+        auto it = std::lower_bound(v.begin(), v.end(), id);
+
+        if (it != v.end() && *it == id) t = { id, tier_t(i), inv.langs[i][it - v.begin()] };
+    }
+
+    if (!t.langs) {
+        berr << COLORED_ERROR ": " << id << " is not in the directory.\n";
+        quit(1);
+    }
+
+    fs::path dir = get_dir(arg);
+    auto saved = judge::load_bench(dir);
+    auto b = judge::bench(dir, t, opts, bopts);
+
+    bout.num(id, 5) << " [" << t.tier.ansi() << t.tier.long_name() << RESET "] ";
+
+    switch (b.report.build) {
+        case judge::report_t::no_source:
+            bout << "no C++ solution\n";
+            quit(1);
+        case judge::report_t::failed:
+            bout << COLORED_TEXT(160, "compile error") "\n";
+            print_log(b.report.log);
+            quit(1);
+        default:
+            bout << (b.report.build == judge::report_t::built ? "built" : "cached") << ", " << b.hash << "\n";
+    }
+
+    if (b.inputs.empty()) {
+        berr << COLORED_ERROR ": No sample inputs in '" << (dir / fs::path(t.tier.path()) / std::to_string(id)).string() << "'\n";
+        quit(1);
+    }
+
+    bout << bopts.runs << " runs per input after " << bopts.warmup << " untimed";
+    if (bopts.cpu >= 0) bout << ", on CPU " << bopts.cpu;
+    bout << "\n";
+
+    // The build to compare with: the newest other build of the problem.
+    // A rerun of the current build keeps comparing with the same one.
+    const judge::saved_t* last = nullptr;
+
+    for (auto& s : saved)
+        if (s.id == id && s.hash != b.hash && (!last || s.ts >= last->ts)) last = &s;
+
+    if (last) {
+        char when[32];
+        std::time_t ts = last->ts;
+        std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M", std::localtime(&ts));
+        bout << "Compared with " << last->hash << " from " << when << "\n";
+    }
+
+    auto right = [] (const std::string& s, std::size_t w) { return std::string(s.size() < w ? w - s.size() : 0, ' ') + s; };
+
+    bout << "\n  ";
+    bout.pad_right("Input", 12);
+    for (const char* h : { "Wall med", "Wall p95", "CPU med", "CPU p95" }) bout << right(h, 12);
+    bout << right("Max RSS", 12) << "\n";
+
+    bool ok = true;
+
+    for (auto& x : b.inputs) {
+        ok &= x.ok;
+
+        bout << "  ";
+        bout.pad_right(x.name, 12);
+        for (i64 v : { x.wall_med, x.wall_p95, x.cpu_med, x.cpu_p95 }) bout << right(ms_str(v), 12);
+        bout << right(mib_str(x.rss_kb), 12);
+        if (!x.ok) bout << "  " COLORED_TEXT(160, "exited with an error");
+        bout << "\n";
+
+        const judge::timing_t* p = nullptr;
+
+        if (last)
+            for (auto& s : saved)
+                if (s.id == id && s.hash == last->hash && s.timing.name == x.name) p = &s.timing;
+
+        if (p) {
+            bout << "    ";
+            bout.pad_right("change", 10);
+            bout << right(delta_str(p->wall_med, x.wall_med), 12) << right(delta_str(p->wall_p95, x.wall_p95), 12)
+                 << right(delta_str(p->cpu_med, x.cpu_med), 12) << right(delta_str(p->cpu_p95, x.cpu_p95), 12)
+                 << right(delta_str(p->rss_kb, x.rss_kb), 12) << "\n";
+        }
+
+        auto& c = x.counters;
+
+        if (c[0] >= 0) {
+            bout << "    " << count_str(c[0]) << " instructions, " << count_str(c[1]) << " cycles";
+
+            if (c[1] > 0) {
+                char ipc[16];
+                std::snprintf(ipc, sizeof(ipc), "%.2f", (f64)c[0] / c[1]);
+                bout << " (" << ipc << " IPC)";
+            }
+
+            bout << ", " << count_str(c[2]) << " cache misses, " << count_str(c[3]) << " branch misses\n";
+        }
+    }
+
+    if (!ok) {
+        bout << "\nResults with errors are not kept.\n";
+        quit(1);
+    }
+
+    if (!judge::save_bench(dir, id, b.hash, std::time(nullptr), b.inputs))
+        berr << COLORED_ERROR ": Could not write '" << judge::bench_path(dir).string() << "'\n";
+}
+
+// "cpp, py" for a lang mask.
+static std::string ext_list(u32 langs) {
+    std::string s;
+
+    for (; langs; langs &= langs - 1) {
+        if (!s.empty()) s += ", ";
+        s += lang::table[__builtin_ctz(langs)].ext;
+    }
+
+    return s;
+}
+
+void fsck(const args& arg) {
+    bout << "\n";
+
+    fs::path dir = get_dir(arg);
+    auto res = bjmgr::layout(dir);
+
+    if (!res.ok()) {
+        help(arg, "fsck", true, res.error().message);
+        quit(1);
+    }
+
+    auto& l = res.value();
+    auto& sols = l.solutions;
+    catalog_t cat;
+
+    using entry_t = layout_t::entry_t;
+
+    std::vector<std::pair<const entry_t*, const entry_t*>> dups;
+    std::vector<move_t> plan;
+    std::vector<const entry_t*> lost;
+    std::size_t checked = 0;
+
+    {
+        PROF_SCOPE("fsck");
+
+        for (std::size_t i = 0, j; i < sols.size(); i = j) {
+            for (j = i + 1; j < sols.size() && sols[j].id == sols[i].id; j++) { }
+
+            // Moving either copy would overwrite the other, so duplicates
+            // are only reported.
+            if (j - i > 1) { dups.push_back({ &sols[i], &sols[j - 1] }); continue; }
+
+            auto& e = sols[i];
+            i32 c = cat.find(e.id);
+            tier_t want = c >= 0 ? tier_t((i32)cat.levels()[c]) : tier_t();
+
+            checked += c >= 0;
+
+            if (e.level.valid()) {
+                if (want.valid() && want != e.level) plan.push_back({ e.id, e.level, want, e.langs });
+                continue;
+            }
+
+            // Outside a level folder: the cached level, else the level the
+            // folder is named after, which is where a scan counts it.
+            if (!want.valid()) want = tier_t(fs::path(e.dir).filename().string());
+
+            if (want.valid()) plan.push_back({ e.id, tier_t(), want, e.langs, e.dir });
+            else lost.push_back(&e);
+        }
+    }
+
+    auto heading = [] (std::string_view name, std::size_t n) {
+        bout << "\n" COLOR(210) << name << RESET " : " << n << "\n";
+    };
+
+    bout << COLORED_TEXT(210, "Solutions") " : " << sols.size() << ", " << checked << " with a cached level\n";
+
+    if (cat.empty())
+        bout << "No levels are cached, so placement is not checked. Run '" APP_NAME " search --sync' first.\n";
+
+    if (!dups.empty()) {
+        heading("In more than one folder", dups.size());
+
+        for (auto [b, e] : dups) {
+            bout << "  ";
+            bout.num(b->id, 5) << " :";
+
+            for (auto p = b; p <= e; p++) bout << (p == b ? " " : ", ") << p->dir << " (" << ext_list(p->langs) << ")";
+            bout << "\n";
+        }
+    }
+
+    if (!l.bad_names.empty()) {
+        heading("Not named <id>.<ext>", l.bad_names.size());
+        for (auto& n : l.bad_names) bout << "  " << n << "\n";
+    }
+
+    if (!l.unknown_dirs.empty()) {
+        heading("Not a level folder", l.unknown_dirs.size());
+        for (auto& n : l.unknown_dirs) bout << "  " << n << "\n";
+    }
+
+    if (!l.orphan_samples.empty()) {
+        heading("Samples without a solution", l.orphan_samples.size());
+        for (auto& n : l.orphan_samples) bout << "  " << n << "\n";
+    }
+
+    if (!lost.empty()) {
+        heading("Level unknown", lost.size());
+
+        for (auto e : lost) {
+            bout << "  ";
+            bout.num(e->id, 5) << " : " << e->dir << "\n";
+        }
+    }
+
+    if (!plan.empty()) {
+        heading("Misplaced", plan.size());
+
+        for (auto& m : plan) {
+            bout << "  ";
+            bout.num(m.id, 5) << " : ";
+
+            if (m.dir.empty()) bout << m.from.ansi() << m.from.long_name() << RESET;
+            else bout << m.dir;
+
+            bout << " -> " << m.to.ansi() << m.to.long_name() << RESET "\n";
+        }
+    }
+
+    std::size_t issues = dups.size() + l.bad_names.size() + l.unknown_dirs.size() + l.orphan_samples.size() + lost.size();
+
+    if (!issues && plan.empty()) {
+        bout << "\nNo problems found.\n";
+        return;
+    }
+
+    if (plan.empty()) quit(1);
+
+    if (!arg.options.count("fix")) {
+        bout << "\nRun '" APP_NAME " fsck --fix' to move " << plan.size() << " misplaced solution(s).\n";
+        quit(1);
+    }
+
+    if (!arg.options.count("yes")) {
+        bout << "\nMove " << plan.size() << " solution(s)? [y/N] ";
+
+        i32 r = getch(true);
+        bout << "\n";
+
+        if (r != 'y' && r != 'Y') {
+            bout << "\nCanceled by user.\n";
+            quit(1);
+        }
+    }
+
+    bout << "\n";
+    progress_t prog("Moving files", plan.size());
+
+    std::size_t err_cnt = 0;
+
+    bjmgr::apply_patch(dir, plan, [&] (const applied_t& a) {
+        if (a.outcome == applied_t::failed) {
+            err_cnt++;
+            berr << COLORED_ERROR ": " << a.move.id << " : " << a.message << "\n";
+        }
+
+        prog.add();
+    });
+
+    prog.finish();
+
+    bout
+        << "\n"
+        << "Total : " << plan.size() << ", Success : " << plan.size() - err_cnt << ", Error : " << err_cnt << "\n";
+
+    if (issues || err_cnt) quit(1);
+}
+
+static i32 run(i32 argc, char** argv);
+
+void daemon_cmd(const args& arg) {
+    std::string path = arg.options.count("socket") ? std::string(*arg.options.at("socket").value) : service::socket_path();
+
+    bout.flush();
+
+    i32 r = service::serve(path, [] (const std::string& cwd, std::vector<std::string>& argv, const int fds[3]) {
+        std::vector<char*> av;
+        for (auto& a : argv) av.push_back(a.data());
+        av.push_back(nullptr);
+
+        if (chdir(cwd.c_str())) {
+            std::string m = COLORED_ERROR ": '" + cwd + "': Cannot enter directory\n";
+            [[maybe_unused]] ssize_t _r = ::write(fds[2], m.data(), m.size());
+            return 1;
+        }
+
+        bout.redirect(fds[1]);
+        berr.redirect(fds[2]);
+        set_input_fd(fds[0]);
+        _serving = true;
+
+        i32 status = 0;
+
+        try {
+            status = run((i32)argv.size(), av.data());
+        } catch (const quit_t& q) {
+            status = q.code;
+        } catch (const std::exception& e) {
+            berr << COLORED_ERROR ": " << e.what() << "\n";
+            status = 1;
+        }
+
+        _serving = false;
+        set_input_fd(STDIN_FILENO);
+        berr.redirect(STDERR_FILENO);
+        bout.redirect(STDOUT_FILENO);
+
+        return status;
+    });
+
+    if (r) quit(r);
+}
+
+// Whether argv can be handed to a running daemon: only the quick commands,
+// nothing that reports through atexit hooks in this process, and nothing
+// that reads the input: ids from stdin, or new, which asks before it
+// overwrites unless given --yes.
+static bool forwardable(i32 argc, char** argv) {
+    if (const char* e = std::getenv("BJMGR_NO_DAEMON"); e && *e && *e != '0') return false;
+
+    const command_t* cmd = find_command(argv[1]);
+    if (!cmd || (cmd->run != info && cmd->run != get && cmd->run != new_file)) return false;
+
+    // A command line that does not parse is reported here.
+    args c;
+    if (parse_command(argc - 2, argv + 2, cmd->opts, c) != parse_error_t::none) return false;
+
+    if (c.options.count("profile") || c.options.count("metrics")) return false;
+    if (cmd->run != info && ids_from_input(c)) return false;
+    if (cmd->run == new_file && !c.options.count("yes")) return false;
+
+    return true;
+}
+
+static i32 run(i32 argc, char** argv) {
+    bout << COLORED_APP_NAME " " APP_VERSION "\n";
     args c;
 
     if (argc == 1) {
         help(c, "help", true, "No specific command");
-        exit(1);
+        return 1;
     }
 
-    std::string cmd = strlib::tolower(argv[1]);
+    const command_t* cmd = find_command(argv[1]);
 
-    init_options(opt_table[cmd]);
+    if (!cmd) {
+        help(c, "help", true, "Unknown command '" + std::string(argv[1]) + "'");
+        return 1;
+    }
 
-    int res;
+    parse_error_t res;
     
-    if ((res = parse_command(std::vector<std::string>(argv + 2, argv + argc), c)) != 0) {
-        help(c, cmd, true, err2str(parse_command, res));
-        exit(1);
+    if ((res = parse_command(argc - 2, argv + 2, cmd->opts, c)) != parse_error_t::none) {
+        help(c, cmd->name, true, parse_errstr(res));
+        return 1;
     }
 
-    int t = tables[cmd];
+    if (c.options.count("profile"))
+        profiler::start(std::string(*c.options.at("profile").value));
+
+    if (c.options.count("metrics"))
+        metrics::start(std::string(*c.options.at("metrics").value), std::string(cmd->name));
 
-    if (!t) help(c, cmd);
-    else ((std::vector<void (*)(const args&)>) {
-        nullptr, info, patch, get, new_file, update
-    })[t](c);
+    if (!cmd->run) help(c, cmd->name);
+    else cmd->run(c);
     
     return 0;
 }
+
+int main(int argc, char** argv) {
+    i32 status;
+
+    if (argc > 1 && forwardable(argc, argv) && service::forward(argc, argv, status))
+        return status;
+
+    return run(argc, argv);
+}
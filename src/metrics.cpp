@@ -0,0 +1,170 @@
+#include "metrics.h"
+#include "tier.h"
+
+#include <map>
+#include <mutex>
+#include <fstream>
+#include <filesystem>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+std::atomic<bool> metrics::_on { false };
+
+static constexpr f64 http_buckets[] = { .05, .1, .25, .5, 1, 2.5, 5, 10 };
+static constexpr i32 bucket_cnt = sizeof(http_buckets) / sizeof(*http_buckets);
+
+static std::mutex _mtx;
+static std::string _path, _command;
+static std::vector<u64> _tiers;
+static u64 _diffs, _created;
+static bool _has_diffs, _has_created, _success;
+static u64 _http_total, _http_429, _http_bytes;
+static std::map<long, u64> _http_status;
+static u64 _http_hist[bucket_cnt + 1];
+static f64 _http_sum;
+static std::vector<std::pair<std::string, f64>> _phases;
+
+void metrics::start(const std::string& path, const std::string& command) {
+    if (_on.exchange(true)) return;
+
+    _path = path;
+    _command = command;
+
+    std::atexit(finish);
+}
+
+void metrics::tier_counts(const std::vector<std::vector<i32>>& ps) {
+    std::lock_guard<std::mutex> lk(_mtx);
+
+    _tiers.assign(31, 0);
+    for (i32 i = 0; i <= 30 && i < (i32)ps.size(); i++) _tiers[i] = ps[i].size();
+}
+
+void metrics::diffs(u64 n) {
+    std::lock_guard<std::mutex> lk(_mtx);
+    _diffs = n; _has_diffs = true;
+}
+
+void metrics::created(u64 n) {
+    std::lock_guard<std::mutex> lk(_mtx);
+    _created += n; _has_created = true;
+}
+
+void metrics::http(f64 seconds, long status, u64 bytes) {
+    std::lock_guard<std::mutex> lk(_mtx);
+
+    _http_total++;
+    _http_status[status]++;
+    if (status == 429) _http_429++;
+    _http_bytes += bytes;
+
+    i32 b = 0;
+    while (b < bucket_cnt && seconds > http_buckets[b]) b++;
+    _http_hist[b]++;
+    _http_sum += seconds;
+}
+
+void metrics::phase(const char* name, f64 seconds) {
+    std::lock_guard<std::mutex> lk(_mtx);
+
+    for (auto& [n, s] : _phases)
+        if (n == name) { s += seconds; return; }
+
+    _phases.emplace_back(name, seconds);
+}
+
+void metrics::success() {
+    std::lock_guard<std::mutex> lk(_mtx);
+    _success = true;
+}
+
+void metrics::finish() {
+    std::lock_guard<std::mutex> lk(_mtx);
+
+    fs::path target(_path);
+    fs::path tmp = target;
+    tmp += ".tmp." + std::to_string(getpid());
+
+    {
+        std::ofstream out(tmp, std::ios::binary);
+        std::string cmd = "command=\"" + _command + "\"";
+        char num[64];
+
+        auto f = [&] (f64 v) { std::snprintf(num, sizeof(num), "%.6g", v); return num; };
+
+        out <<
+            "# HELP bjmgr_last_run_success Whether the last run finished without error.\n"
+            "# TYPE bjmgr_last_run_success gauge\n"
+            "bjmgr_last_run_success{" << cmd << "} " << (i32)_success << "\n"
+            "# HELP bjmgr_last_run_timestamp_seconds Unix time the last run ended.\n"
+            "# TYPE bjmgr_last_run_timestamp_seconds gauge\n"
+            "bjmgr_last_run_timestamp_seconds{" << cmd << "} " << std::time(nullptr) << "\n";
+
+        if (!_tiers.empty()) {
+            out <<
+                "# HELP bjmgr_problems Local solution files per tier level.\n"
+                "# TYPE bjmgr_problems gauge\n";
+
+            for (i32 i = 1; i <= 30; i++)
+                out << "bjmgr_problems{" << cmd << ",tier=\"" << tier_t(i).short_name() << "\"} " << _tiers[i] << "\n";
+        }
+
+        if (_has_diffs)
+            out <<
+                "# HELP bjmgr_diffs Problems whose tier differs from solved.ac.\n"
+                "# TYPE bjmgr_diffs gauge\n"
+                "bjmgr_diffs{" << cmd << "} " << _diffs << "\n";
+
+        if (_has_created)
+            out <<
+                "# HELP bjmgr_created Files created by this run.\n"
+                "# TYPE bjmgr_created gauge\n"
+                "bjmgr_created{" << cmd << "} " << _created << "\n";
+
+        out <<
+            "# HELP bjmgr_http_requests Requests sent to solved.ac by status code.\n"
+            "# TYPE bjmgr_http_requests gauge\n";
+        for (auto& [code, n] : _http_status)
+            out << "bjmgr_http_requests{" << cmd << ",code=\"" << code << "\"} " << n << "\n";
+
+        out <<
+            "# HELP bjmgr_http_rate_limited Responses with status 429.\n"
+            "# TYPE bjmgr_http_rate_limited gauge\n"
+            "bjmgr_http_rate_limited{" << cmd << "} " << _http_429 << "\n"
+            "# HELP bjmgr_http_response_bytes Bytes downloaded from solved.ac.\n"
+            "# TYPE bjmgr_http_response_bytes gauge\n"
+            "bjmgr_http_response_bytes{" << cmd << "} " << _http_bytes << "\n"
+            "# HELP bjmgr_http_request_duration_seconds Request latency.\n"
+            "# TYPE bjmgr_http_request_duration_seconds histogram\n";
+
+        u64 acc = 0;
+        for (i32 b = 0; b < bucket_cnt; b++) {
+            acc += _http_hist[b];
+            out << "bjmgr_http_request_duration_seconds_bucket{" << cmd << ",le=\"" << f(http_buckets[b]) << "\"} " << acc << "\n";
+        }
+        acc += _http_hist[bucket_cnt];
+
+        out <<
+            "bjmgr_http_request_duration_seconds_bucket{" << cmd << ",le=\"+Inf\"} " << acc << "\n"
+            "bjmgr_http_request_duration_seconds_sum{" << cmd << "} " << f(_http_sum) << "\n"
+            "bjmgr_http_request_duration_seconds_count{" << cmd << "} " << _http_total << "\n";
+
+        if (!_phases.empty()) {
+            out <<
+                "# HELP bjmgr_phase_duration_seconds Wall time spent per phase.\n"
+                "# TYPE bjmgr_phase_duration_seconds gauge\n";
+
+            for (auto& [n, s] : _phases)
+                out << "bjmgr_phase_duration_seconds{" << cmd << ",phase=\"" << n << "\"} " << f(s) << "\n";
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(tmp, target, ec);
+    if (ec) fs::remove(tmp, ec);
+}
@@ -0,0 +1,72 @@
+#include "output.h"
+
+#include <exception>
+#include <cstring>
+#include <cerrno>
+
+#include <unistd.h>
+
+writer_t bout(STDOUT_FILENO);
+writer_t berr(STDERR_FILENO, 1 << 12, &bout);
+
+// std::terminate skips static destructors, so an uncaught exception would
+// drop whatever is still buffered, the error that led to it included.
+static const std::terminate_handler _prev_terminate = std::set_terminate([] {
+    bout.flush();
+    berr.flush();
+    _prev_terminate();
+});
+
+static void write_all(int fd, const char* s, std::size_t n) {
+    while (n) {
+        ssize_t r = ::write(fd, s, n);
+
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+
+        s += r; n -= r;
+    }
+}
+
+writer_t::writer_t(int __fd, std::size_t __cap, writer_t* __tie)
+: _buf(new char[__cap]), _cap(__cap), _fd(__fd), _tie(__tie) { }
+
+writer_t::~writer_t() { flush(); }
+
+void writer_t::prepare(std::size_t n) {
+    if (_len == 0 && _tie) _tie->flush();
+    if (_len + n > _cap) flush();
+}
+
+writer_t& writer_t::write(const char* s, std::size_t n) {
+    prepare(n);
+
+    // Larger than the whole buffer: nothing to gain from copying.
+    if (n > _cap) { write_all(_fd, s, n); return *this; }
+
+    std::memcpy(_buf.get() + _len, s, n);
+    _len += n;
+
+    return *this;
+}
+
+writer_t& writer_t::fill(char c, i32 cnt) {
+    while (cnt > 0) {
+        prepare(1);
+
+        std::size_t k = std::min<std::size_t>(cnt, _cap - _len);
+        std::memset(_buf.get() + _len, c, k);
+        _len += k; cnt -= k;
+    }
+
+    return *this;
+}
+
+void writer_t::flush() {
+    if (_len == 0) return;
+
+    write_all(_fd, _buf.get(), _len);
+    _len = 0;
+}
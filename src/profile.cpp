@@ -0,0 +1,111 @@
+#include "profile.h"
+#include "output.h"
+#include "ansi.h"
+
+#include <vector>
+#include <map>
+#include <mutex>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+struct prof_event {
+    const char *name, *cat;
+    i64 start, dur, arg;
+    i32 tid;
+};
+
+std::atomic<bool> profiler::_on { false };
+
+static std::mutex _mtx;
+static std::vector<prof_event> _events;
+static std::string _path;
+static i64 _origin;
+static std::atomic<i32> _next_tid { 0 };
+
+static i32 thread_index() {
+    thread_local i32 tid = _next_tid.fetch_add(1);
+    return tid;
+}
+
+void profiler::start(const std::string& path) {
+    if (_on.exchange(true)) return;
+
+    _path = path;
+    _origin = now_ns();
+    _events.reserve(1 << 12);
+
+    std::atexit(finish);
+}
+
+void profiler::record(const char* name, const char* cat, i64 start_ns, i64 dur_ns, i64 arg) {
+    i32 tid = thread_index();
+
+    std::lock_guard<std::mutex> lk(_mtx);
+    _events.push_back({ name, cat, start_ns, dur_ns, arg, tid });
+}
+
+static f64 percentile(const std::vector<i64>& v, f64 p) {
+    std::size_t k = std::min(v.size() - 1, (std::size_t)(p * (v.size() - 1) + 0.5));
+    return v[k] / 1e6;
+}
+
+void profiler::finish() {
+    _on.store(false);
+
+    std::lock_guard<std::mutex> lk(_mtx);
+
+    {
+        std::ofstream out(_path, std::ios::binary);
+        char line[512];
+
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+        for (std::size_t i = 0; i < _events.size(); i++) {
+            auto& e = _events[i];
+            int n = std::snprintf(
+                line, sizeof(line),
+                "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                i ? ",\n" : "", e.name, e.cat, e.tid, (e.start - _origin) / 1e3, e.dur / 1e3
+            );
+
+            if (e.arg >= 0)
+                n += std::snprintf(line + n, sizeof(line) - n, ",\"args\":{\"id\":%lld}", (long long)e.arg);
+
+            n += std::snprintf(line + n, sizeof(line) - n, "}");
+            out.write(line, n);
+        }
+
+        out << "\n]}\n";
+    }
+
+    // Summary per scope name, in milliseconds.
+    std::map<std::string, std::vector<i64>> by_name;
+    for (auto& e : _events) by_name[e.name].push_back(e.dur);
+
+    bout << "\n" COLORED_TEXT(219, "Profile") " : " << _path << " (times in ms)\n";
+
+    char line[160];
+    std::snprintf(
+        line, sizeof(line), "  %-10s %7s %10s %9s %9s %9s %9s\n",
+        "scope", "count", "total", "p50", "p90", "p99", "max"
+    );
+    bout << line;
+
+    for (auto& [name, v] : by_name) {
+        std::sort(v.begin(), v.end());
+
+        i64 total = 0;
+        for (auto d : v) total += d;
+
+        std::snprintf(
+            line, sizeof(line), "  %-10s %7zu %10.2f %9.3f %9.3f %9.3f %9.3f\n",
+            name.c_str(), v.size(), total / 1e6,
+            percentile(v, .5), percentile(v, .9), percentile(v, .99), v.back() / 1e6
+        );
+        bout << line;
+    }
+
+    bout.flush();
+}
@@ -0,0 +1,98 @@
+#include "progress.h"
+#include "output.h"
+
+#include <algorithm>
+
+#include <cstdio>
+#include <cerrno>
+
+#include <unistd.h>
+
+progress_t::progress_t(std::string_view __label, u64 __total, std::chrono::milliseconds __interval)
+: _label(__label), _total(__total), _interval(__interval), _start(clock::now()),
+  _tty(isatty(bout.fd())) {
+    if (!_tty) return;
+
+    // The reporter writes to the fd directly, so anything queued must go first.
+    bout.flush();
+    _th = std::thread(&progress_t::run, this);
+}
+
+progress_t::~progress_t() {
+    {
+        std::lock_guard<std::mutex> lk(_mtx);
+        _stop = true;
+    }
+
+    _cv.notify_one();
+    if (_th.joinable()) _th.join();
+}
+
+void progress_t::run() {
+    std::unique_lock<std::mutex> lk(_mtx);
+
+    while (!_cv.wait_for(lk, _interval, [this] { return _stop; }))
+        draw();
+}
+
+void progress_t::draw() {
+    u64 done = _done.load(std::memory_order_relaxed);
+    u64 total = _total.load(std::memory_order_relaxed);
+    f64 sec = std::chrono::duration<f64>(clock::now() - _start).count();
+    f64 rate = sec > 0 ? done / sec : 0;
+
+    char line[256];
+    int n = 0;
+
+    // snprintf returns the length it wanted, so a long label would move n
+    // past the buffer; clamp after every piece.
+    auto put = [&] (const char* fmt, auto... v) {
+        int k = std::snprintf(line + n, sizeof(line) - n, fmt, v...);
+        if (k > 0) n = std::min<int>(n + k, sizeof(line) - 1);
+    };
+
+    put("\r%s... ", _label.c_str());
+
+    if (total)
+        put("%d%% (%llu/%llu", (i32)(done * 100 / total), (unsigned long long)done, (unsigned long long)total);
+    else
+        put("(%llu", (unsigned long long)done);
+
+    put(", %.1f/s", rate);
+
+    if (total && done && done < total && rate > 0)
+        put(", ETA %llus", (unsigned long long)((total - done) / rate + 0.5));
+
+    // Shorter than the previous draw: blank out what is left of it.
+    put(")    ");
+
+    for (int off = 0; off < n;) {
+        ssize_t r = ::write(bout.fd(), line + off, n - off);
+
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+
+        off += r;
+    }
+}
+
+void progress_t::finish() {
+    {
+        std::lock_guard<std::mutex> lk(_mtx);
+        _stop = true;
+    }
+
+    _cv.notify_one();
+    if (_th.joinable()) _th.join();
+
+    if (_tty) {
+        bout << '\r';
+        bout.fill(' ', 80);
+        bout << '\r';
+    }
+
+    bout << _label << "... Done.\n";
+    bout.flush();
+}
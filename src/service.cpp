@@ -0,0 +1,280 @@
+#include "service.h"
+#include "output.h"
+#include "ansi.h"
+
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+// A request is a u32 payload size sent together with the client's fds 0-2
+// (SCM_RIGHTS), then the payload: the working directory, the client's
+// value of each forwarded variable that is set as "NAME=value", an empty
+// entry, and every argv entry, each terminated by '\0'. The reply is the
+// i32 exit status.
+
+static constexpr u32 max_payload = 1 << 20;
+
+// Variables a forwarded command reads, taken from the client rather than
+// from whatever the daemon was started with.
+static constexpr const char* forwarded_env[] = { "BJMGR_API_URL", "BJMGR_NO_INDEX", "BJMGR_CATALOG" };
+
+static volatile std::sig_atomic_t _stop = 0;
+
+std::string service::socket_path() {
+    if (const char* e = std::getenv("BJMGR_SOCKET"); e && *e) return e;
+    if (const char* e = std::getenv("XDG_RUNTIME_DIR"); e && *e) return std::string(e) + "/bjmgr.sock";
+
+    return "/tmp/bjmgr-" + std::to_string(getuid()) + ".sock";
+}
+
+static bool make_addr(const std::string& path, sockaddr_un& addr) {
+    if (path.size() >= sizeof(addr.sun_path)) return false;
+
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+    return true;
+}
+
+static bool read_all(int fd, void* p, size_t n) {
+    char* s = (char*)p;
+
+    while (n) {
+        ssize_t r = ::read(fd, s, n);
+
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+
+        s += r; n -= r;
+    }
+
+    return true;
+}
+
+static bool write_all(int fd, const void* p, size_t n) {
+    const char* s = (const char*)p;
+
+    while (n) {
+        ssize_t r = ::write(fd, s, n);
+
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+
+        s += r; n -= r;
+    }
+
+    return true;
+}
+
+static int connect_to(const std::string& path) {
+    sockaddr_un addr;
+    if (!make_addr(path, addr)) return -1;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr))) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+bool service::forward(i32 argc, char** argv, i32& status) {
+    int fd = connect_to(socket_path());
+    if (fd < 0) return false;
+
+    std::string payload;
+    if (char* cwd = getcwd(nullptr, 0)) { payload = cwd; std::free(cwd); }
+    else { close(fd); return false; }
+
+    payload += '\0';
+
+    for (auto name : forwarded_env) {
+        if (const char* e = std::getenv(name)) { payload += name; payload += '='; payload += e; payload += '\0'; }
+    }
+
+    payload += '\0';
+    for (i32 i = 0; i < argc; i++) { payload += argv[i]; payload += '\0'; }
+
+    u32 size = payload.size();
+    int fds[3] = { STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO };
+
+    iovec iov { &size, sizeof(size) };
+    alignas(cmsghdr) char ctrl[CMSG_SPACE(sizeof(fds))] { };
+
+    msghdr msg { };
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl;
+    msg.msg_controllen = sizeof(ctrl);
+
+    cmsghdr* c = CMSG_FIRSTHDR(&msg);
+    c->cmsg_level = SOL_SOCKET;
+    c->cmsg_type = SCM_RIGHTS;
+    c->cmsg_len = CMSG_LEN(sizeof(fds));
+    std::memcpy(CMSG_DATA(c), fds, sizeof(fds));
+
+    // Nothing has been sent yet if this fails, so running locally is safe.
+    if (sendmsg(fd, &msg, MSG_NOSIGNAL) != (ssize_t)sizeof(size)) {
+        close(fd);
+        return false;
+    }
+
+    bout.flush();
+
+    if (!write_all(fd, payload.data(), payload.size()) || !read_all(fd, &status, sizeof(status))) {
+        berr << COLORED_ERROR ": Lost connection to the daemon\n";
+        status = 1;
+    }
+
+    close(fd);
+    return true;
+}
+
+static void on_signal(int) { _stop = 1; }
+
+// Read one request from conn and run it through handler.
+static void handle(int conn, service::handler_t handler) {
+    u32 size = 0;
+    int fds[3] = { -1, -1, -1 };
+
+    iovec iov { &size, sizeof(size) };
+    alignas(cmsghdr) char ctrl[CMSG_SPACE(sizeof(fds))] { };
+
+    msghdr msg { };
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl;
+    msg.msg_controllen = sizeof(ctrl);
+
+    ssize_t r;
+    while ((r = recvmsg(conn, &msg, MSG_CMSG_CLOEXEC)) < 0 && errno == EINTR);
+
+    i32 n = 0;
+    for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+        if (c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_RIGHTS) continue;
+
+        n = (c->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        std::memcpy(fds, CMSG_DATA(c), std::min<size_t>(n, 3) * sizeof(int));
+    }
+
+    auto done = [&] {
+        for (i32 i = 0; i < std::min(n, 3); i++) close(fds[i]);
+    };
+
+    if (r != (ssize_t)sizeof(size) || n != 3 || size > max_payload) { done(); return; }
+
+    std::string payload(size, '\0');
+    if (!read_all(conn, payload.data(), size) || payload.empty() || payload.back() != '\0') { done(); return; }
+
+    std::vector<std::string> parts;
+    for (size_t p = 0; p < payload.size(); ) {
+        size_t e = payload.find('\0', p);
+        parts.emplace_back(payload, p, e - p);
+        p = e + 1;
+    }
+
+    std::string cwd = std::move(parts[0]);
+    size_t k = 1;
+
+    // A variable the client did not send is unset, not left as it was.
+    for (auto name : forwarded_env) unsetenv(name);
+
+    for (; k < parts.size() && !parts[k].empty(); k++) {
+        auto eq = parts[k].find('=');
+        std::string name = parts[k].substr(0, eq);
+
+        for (auto f : forwarded_env) {
+            if (eq != std::string::npos && name == f) setenv(f, parts[k].c_str() + eq + 1, 1);
+        }
+    }
+
+    if (k == parts.size()) { done(); return; }
+
+    std::vector<std::string> argv(std::make_move_iterator(parts.begin() + k + 1), std::make_move_iterator(parts.end()));
+
+    i32 status = argv.empty() ? 1 : handler(cwd, argv, fds);
+
+    done();
+    write_all(conn, &status, sizeof(status));
+}
+
+i32 service::serve(const std::string& path, handler_t handler) {
+    sockaddr_un addr;
+
+    if (!make_addr(path, addr)) {
+        berr << COLORED_ERROR ": '" << path << "': Socket path is too long\n";
+        return 1;
+    }
+
+    if (int fd = connect_to(path); fd >= 0) {
+        close(fd);
+        berr << COLORED_ERROR ": A daemon is already listening on '" << path << "'\n";
+        return 1;
+    }
+
+    // Nobody answered, so whatever is left there is stale.
+    unlink(path.c_str());
+
+    int srv = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    // Forwarded commands write files as this user: keep the socket private.
+    mode_t um = umask(077);
+    bool ok = srv >= 0 && !bind(srv, (sockaddr*)&addr, sizeof(addr)) && !listen(srv, 16);
+    umask(um);
+
+    if (!ok) {
+        berr << COLORED_ERROR ": '" << path << "': " << std::strerror(errno) << "\n";
+        if (srv >= 0) close(srv);
+        return 1;
+    }
+
+    struct sigaction sa { };
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // Forwarded commands use the client's terminal. Out of its session it
+    // is not our controlling terminal and job control leaves us alone, but
+    // started with '&' we lead our process group and setsid() fails; then a
+    // read from it or a tcsetattr would stop the daemon, and every client
+    // queued behind it. With the signals ignored the read fails with EIO and
+    // tcsetattr goes through.
+    setsid();
+    std::signal(SIGTTIN, SIG_IGN);
+    std::signal(SIGTTOU, SIG_IGN);
+
+    bout << "Listening on " << path << "\n";
+    bout.flush();
+
+    while (!_stop) {
+        int conn = accept4(srv, nullptr, nullptr, SOCK_CLOEXEC);
+
+        if (conn < 0) continue;
+
+        ucred cred { };
+        socklen_t len = sizeof(cred);
+
+        if (!getsockopt(conn, SOL_SOCKET, SO_PEERCRED, &cred, &len) && cred.uid == getuid())
+            handle(conn, handler);
+
+        close(conn);
+    }
+
+    close(srv);
+    unlink(path.c_str());
+
+    bout << "Daemon stopped.\n";
+    return 0;
+}
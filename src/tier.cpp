@@ -1,42 +0,0 @@
-#include "tier.h"
-
-const std::tuple<i32, i32, i32> tier_t::color_table[] = {
-    // Unrated
-    {  45,  45,  45 },
-    // Bronze
-    { 157,  73,   0 },
-    { 165,  79,   0 },
-    { 173,  86,   0 },
-    { 181,  93,  10 },
-    { 198, 119,  57 },
-    // Silver
-    {  56,  84, 110 },
-    {  61,  90, 116 },
-    {  67,  95, 122 },
-    {  73, 105, 137 },
-    {  78, 106, 134 },
-    // Gold
-    { 210, 133,   0 },
-    { 223, 143,   0 },
-    { 236, 154,   0 },
-    { 249, 165,  24 },
-    { 255, 176,  40 },
-    // Platinum
-    {   0, 199, 139 },
-    {   0, 212, 151 },
-    {  39, 226, 164 },
-    {  62, 240, 177 },
-    {  81, 253, 189 },
-    // Diamond
-    {   0, 158, 229 },
-    {   0, 169, 240 },
-    {   0, 180, 252 },
-    {  43, 191, 255 },
-    {  65, 202, 255 },
-    // Ruby
-    { 254,   0,  76 },
-    { 234,   0,  83 },
-    { 245,   0,  90 },
-    { 255,   0,  98 },
-    { 255,  48, 113 }
-};
\ No newline at end of file
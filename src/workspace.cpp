@@ -0,0 +1,521 @@
+#include "workspace.h"
+#include "tier.h"
+#include "strlib.h"
+#include "lang.h"
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <functional>
+#include <charconv>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+// Every line after the header is
+// "<mtime>\t<path>\t<subdirs>\t<ids>\t<files>\t", with the path relative
+// to the root, subdirectory names separated by '/', ids by ',' as
+// "<id>:<language mask>" and files by '/' as "<name>,<mtime>,<size>,<lines>".
+static constexpr std::string_view index_header = "bjmgr-index 3";
+
+// A "<id>.<ext>" file; mtime is 0 until it has been read, or when it
+// changed too recently to be trusted.
+struct file_t {
+    std::string name;
+    i64 mtime = 0;
+    u64 size = 0, lines = 0;
+};
+
+struct dir_t {
+    // 0 when the directory changed too recently to be trusted.
+    i64 mtime = 0;
+    std::vector<std::string> subdirs;
+    // Solutions in a registered language, sorted, with their lang masks.
+    std::vector<i32> ids;
+    std::vector<u32> langs;
+    std::vector<file_t> files;
+};
+
+using index_t = std::unordered_map<std::string, dir_t>;
+
+static i64 mtime_of(const struct stat& st) { return (i64)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec; }
+
+static bool stat_dir(const fs::path& p, i64& mtime) {
+    struct stat st;
+    if (::stat(p.c_str(), &st) || !S_ISDIR(st.st_mode)) return false;
+
+    mtime = mtime_of(st);
+    return true;
+}
+
+// "<digits>.<ext>", with nothing in it the index uses as a separator.
+static bool solution_name(std::string_view s) {
+    auto dot = s.find('.');
+
+    return dot && dot != std::string_view::npos && dot + 1 < s.size() &&
+        std::all_of(s.begin(), s.begin() + dot, [] (char c) { return c >= '0' && c <= '9'; }) &&
+        s.find_first_of(",/\t\n") == std::string_view::npos;
+}
+
+template <typename T>
+static bool parse_num(std::string_view s, T& v) {
+    auto r = std::from_chars(s.data(), s.data() + s.size(), v);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size();
+}
+
+static index_t load(const fs::path& file) {
+    index_t idx;
+    std::string buf;
+
+    if (std::FILE* f = std::fopen(file.c_str(), "rb")) {
+        char tmp[1 << 16];
+        for (size_t n; (n = std::fread(tmp, 1, sizeof(tmp), f)); ) buf.append(tmp, n);
+        std::fclose(f);
+    }
+
+    bool header = true, ok = true;
+
+    strlib::split_views(buf, '\n', [&] (std::string_view ln) {
+        if (!ok) return;
+        if (header) { ok = ln == index_header; header = false; return; }
+
+        std::string_view f[5];
+        i32 k = 0;
+        strlib::split_views(ln, '\t', [&] (std::string_view x) { if (k < 5) f[k] = x; k++; });
+
+        dir_t d;
+        if (k != 5 || !parse_num(f[0], d.mtime)) { ok = false; return; }
+
+        strlib::split_views(f[2], '/', [&] (std::string_view s) { d.subdirs.emplace_back(s); });
+        strlib::split_views(f[3], ',', [&] (std::string_view s) {
+            auto c = s.find(':');
+            i32 id;
+            u32 mask;
+
+            if (c != std::string_view::npos && parse_num(s.substr(0, c), id) && parse_num(s.substr(c + 1), mask)) {
+                d.ids.push_back(id);
+                d.langs.push_back(mask);
+            } else ok = false;
+        });
+        strlib::split_views(f[4], '/', [&] (std::string_view s) {
+            std::string_view g[4];
+            i32 n = 0;
+            strlib::split_views(s, ',', [&] (std::string_view x) { if (n < 4) g[n] = x; n++; });
+
+            file_t e { std::string(g[0]) };
+            if (n == 4 && parse_num(g[1], e.mtime) && parse_num(g[2], e.size) && parse_num(g[3], e.lines))
+                d.files.push_back(std::move(e));
+            else ok = false;
+        });
+
+        idx.emplace(f[1], std::move(d));
+    });
+
+    if (!ok) idx.clear();
+
+    return idx;
+}
+
+static void save(const index_t& idx, const fs::path& dir) {
+    std::string out(index_header);
+    out += '\n';
+
+    for (const auto& [rel, d] : idx) {
+        strlib::append(out, d.mtime); out += '\t';
+        out += rel; out += '\t';
+        strlib::append_join(out, d.subdirs.begin(), d.subdirs.end(), "/"); out += '\t';
+        for (std::size_t i = 0; i < d.ids.size(); i++) {
+            if (i) out += ',';
+            strlib::append(out, d.ids[i]); out += ':';
+            strlib::append(out, d.langs[i]);
+        }
+
+        out += '\t';
+
+        for (std::size_t i = 0; i < d.files.size(); i++) {
+            auto& e = d.files[i];
+
+            if (i) out += '/';
+            out += e.name; out += ',';
+            strlib::append(out, e.mtime); out += ',';
+            strlib::append(out, e.size); out += ',';
+            strlib::append(out, e.lines);
+        }
+
+        out += "\t\n";
+    }
+
+    std::error_code ec;
+    fs::create_directory(dir, ec);
+
+    fs::path file = dir / "index", tmp = file;
+    tmp += ".tmp." + std::to_string(getpid());
+
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) return;
+
+    bool ok = std::fwrite(out.data(), 1, out.size(), f) == out.size();
+    ok = std::fclose(f) == 0 && ok;
+
+    if (ok) fs::rename(tmp, file, ec);
+    if (!ok || ec) fs::remove(tmp, ec);
+}
+
+namespace {
+
+struct scanner {
+    const fs::path& root;
+    // (id, lang mask) per level code.
+    std::vector<std::vector<std::pair<i32, u32>>> found;
+    index_t old, cur;
+    // Directories modified after this are re-read next time, since a
+    // change within the same mtime tick would otherwise go unnoticed.
+    i64 fresh;
+    bool dirty = false, indexable = true;
+
+    void visit(const std::string& rel) {
+        fs::path p = root / rel;
+        i64 mtime;
+
+        if (!stat_dir(p, mtime)) return;
+
+        dir_t d;
+        auto it = old.find(rel);
+
+        if (it != old.end() && it->second.mtime && it->second.mtime == mtime)
+            d = std::move(it->second);
+        else {
+            dirty = true;
+            d.mtime = mtime < fresh ? mtime : 0;
+
+            // Counts of files still there are kept; stats() checks them.
+            std::unordered_map<std::string, file_t> known;
+            if (it != old.end())
+                for (auto& e : it->second.files) known.emplace(e.name, std::move(e));
+
+            std::vector<std::pair<i32, u32>> sols;
+
+            for (const auto& e : fs::directory_iterator(p)) {
+                if (e.is_directory()) { d.subdirs.push_back(e.path().filename().string()); continue; }
+
+                std::string s = e.path().filename().string();
+                if (!solution_name(s)) continue;
+
+                auto dot = s.find('.');
+
+                if (u32 b = lang::bit(std::string_view(s).substr(dot + 1)); b) {
+                    i32 id;
+                    if (parse_num(std::string_view(s).substr(0, dot), id)) sols.emplace_back(id, b);
+                }
+
+                auto k = known.find(s);
+                d.files.push_back(k != known.end() ? std::move(k->second) : file_t { s });
+            }
+
+            // One entry per problem, with the bits of all its files.
+            std::sort(sols.begin(), sols.end());
+
+            for (auto& [id, b] : sols) {
+                if (!d.ids.empty() && d.ids.back() == id) d.langs.back() |= b;
+                else { d.ids.push_back(id); d.langs.push_back(b); }
+            }
+
+            for (const auto& s : d.subdirs)
+                if (s.find_first_of("\t\n") != std::string::npos) indexable = false;
+        }
+
+        auto& v = found[(i32)tier_t(p.filename().string())];
+        for (std::size_t i = 0; i < d.ids.size(); i++) v.emplace_back(d.ids[i], d.langs[i]);
+
+        std::vector<std::string> subs = d.subdirs;
+        cur.emplace(rel, std::move(d));
+
+        for (const auto& s : subs) visit(rel + "/" + s);
+    }
+};
+
+}
+
+// Indexes already read by this process, by absolute root. A long-running
+// daemon only goes to disk for a workspace once.
+static std::unordered_map<std::string, index_t> _loaded;
+
+// Scan root into ps and langs. update, if set, may change the cached file
+// counts of the index before it is saved, and returns whether it did.
+static void scan_root(
+    std::vector<std::vector<i32>>& ps, std::vector<std::vector<u32>>& langs,
+    const fs::path& root, const std::function<bool(index_t&)>& update
+) {
+    const char* e = std::getenv("BJMGR_NO_INDEX");
+    bool use_index = !(e && *e && *e != '0') && fs::is_directory(root);
+
+    fs::path dir = root / ".bjmgr";
+    std::string key = use_index ? fs::absolute(root).lexically_normal().string() : "";
+
+    index_t old;
+    if (use_index) {
+        auto it = _loaded.find(key);
+        old = it != _loaded.end() ? std::move(it->second) : load(dir / "index");
+    }
+
+    scanner sc { root, std::vector<std::vector<std::pair<i32, u32>>>(32), std::move(old), { }, 0 };
+
+    sc.fresh = ((i64)std::time(nullptr) - 2) * 1000000000;
+    std::size_t loaded = sc.old.size();
+
+    for (const char* folder : { "Bronze", "Silver", "Gold", "Platinum", "Diamond", "Ruby" })
+        sc.visit(folder);
+
+    ps.assign(32, { });
+    langs.assign(32, { });
+
+    for (i32 i = 0; i < 32; i++) {
+        auto& v = sc.found[i];
+        std::sort(v.begin(), v.end());
+
+        for (auto& [id, b] : v) { ps[i].push_back(id); langs[i].push_back(b); }
+    }
+
+    bool counted = update && update(sc.cur);
+
+    if (!use_index || !sc.indexable) return;
+
+    if (sc.dirty || counted || sc.cur.size() != loaded) save(sc.cur, dir);
+    _loaded[key] = std::move(sc.cur);
+}
+
+void workspace::scan(std::vector<std::vector<i32>>& ps, std::vector<std::vector<u32>>& langs, const fs::path& root) {
+    scan_root(ps, langs, root, { });
+}
+
+// Size and line count of the file at p, read through a private mapping.
+static bool count_file(const fs::path& p, const struct stat& st, u64& lines) {
+    lines = 0;
+    if (!st.st_size) return true;
+
+    int fd = ::open(p.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    void* m = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (m == MAP_FAILED) return false;
+
+    madvise(m, st.st_size, MADV_SEQUENTIAL);
+
+    std::string_view s((const char*)m, st.st_size);
+    lines = strlib::count(s, '\n') + (s.back() != '\n');
+
+    munmap(m, st.st_size);
+    return true;
+}
+
+std::vector<std::map<std::string, file_stats_t>> workspace::stats(const fs::path& root) {
+    std::vector<std::map<std::string, file_stats_t>> out(32);
+    std::vector<std::vector<i32>> ps;
+    std::vector<std::vector<u32>> langs;
+
+    scan_root(ps, langs, root, [&] (index_t& idx) {
+        struct job_t { i32 level; fs::path path; file_t* file; bool ok; };
+        std::vector<job_t> jobs;
+
+        for (auto& [rel, d] : idx) {
+            std::string name = fs::path(rel).filename().string();
+            tier_t t(name);
+
+            // Level folders only, as in scan(); sample folders such as
+            // "Bronze/Bronze 5/1000" also parse as level 0.
+            if (fs::path(t.path()).filename() != name) continue;
+
+            i32 level = (i32)t;
+            for (auto& e : d.files) jobs.push_back({ level, root / rel / e.name, &e, false });
+        }
+
+        const i64 fresh = ((i64)std::time(nullptr) - 2) * 1000000000;
+        std::atomic<std::size_t> next { 0 };
+        std::atomic<bool> changed { false };
+
+        auto work = [&] {
+            for (std::size_t i; (i = next++) < jobs.size(); ) {
+                auto& j = jobs[i];
+                struct stat st;
+
+                if (::stat(j.path.c_str(), &st) || !S_ISREG(st.st_mode)) continue;
+
+                i64 mt = mtime_of(st);
+                file_t& e = *j.file;
+
+                if (!e.mtime || e.mtime != mt || e.size != (u64)st.st_size) {
+                    u64 lines;
+                    if (!count_file(j.path, st, lines)) continue;
+
+                    e.mtime = mt < fresh ? mt : 0;
+                    e.size = st.st_size;
+                    e.lines = lines;
+                    changed = true;
+                }
+
+                j.ok = true;
+            }
+        };
+
+        // A thread per core, but none for fewer than 64 files each.
+        std::size_t n = std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()), jobs.size() / 64 + 1);
+        std::vector<std::thread> pool;
+
+        for (std::size_t t = 1; t < n; t++) pool.emplace_back(work);
+        work();
+        for (auto& t : pool) t.join();
+
+        for (auto& j : jobs) {
+            if (!j.ok) continue;
+
+            auto& e = *j.file;
+            auto& s = out[j.level][e.name.substr(e.name.find('.') + 1)];
+
+            s.files++;
+            s.stubs += !e.size;
+            s.lines += e.lines;
+            s.bytes += e.size;
+        }
+
+        return changed.load();
+    });
+
+    return out;
+}
+
+// A tier folder or a level folder, and what was found in it and below.
+struct layout_job_t {
+    std::string rel;
+    tier_t level;
+    bool tier_folder;
+    std::vector<layout_t::entry_t> solutions;
+    std::vector<std::string> bad_names, unknown_dirs, orphan_samples;
+};
+
+// List rel into j. Subfolders of a tier folder are jobs of their own;
+// below a level folder, only sample folders are expected.
+static void list_layout(const fs::path& root, const std::string& rel, tier_t level, layout_job_t& j) {
+    const bool top = rel == j.rel;
+
+    std::error_code ec;
+    std::vector<std::pair<i32, u32>> sols;
+    std::vector<std::pair<i32, std::string>> samples;
+
+    for (auto it = fs::directory_iterator(root / rel, ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+        std::string s = it->path().filename().string();
+        if (s[0] == '.') continue;
+
+        std::error_code e2;
+
+        if (it->is_directory(e2)) {
+            if (top && j.tier_folder) continue;
+
+            // Samples of a solution, as test reads them.
+            if (top && level.valid() && std::all_of(s.begin(), s.end(), [] (char c) { return c >= '0' && c <= '9'; })) {
+                i32 id;
+                if (parse_num(s, id)) samples.emplace_back(id, rel + "/" + s);
+                continue;
+            }
+
+            j.unknown_dirs.push_back(rel + "/" + s);
+            list_layout(root, rel + "/" + s, tier_t(), j);
+            continue;
+        }
+
+        auto dot = s.find('.');
+        u32 b = solution_name(s) ? lang::bit(std::string_view(s).substr(dot + 1)) : 0;
+        i32 id;
+
+        if (b && parse_num(std::string_view(s).substr(0, dot), id)) sols.emplace_back(id, b);
+        else j.bad_names.push_back(rel + "/" + s);
+    }
+
+    std::sort(sols.begin(), sols.end());
+
+    for (std::size_t i = 0; i < sols.size(); i++) {
+        if (i && sols[i].first == sols[i - 1].first) j.solutions.back().langs |= sols[i].second;
+        else j.solutions.push_back({ sols[i].first, sols[i].second, rel, level });
+    }
+
+    // test only looks for samples next to the solution.
+    for (auto& [id, path] : samples) {
+        auto it = std::lower_bound(sols.begin(), sols.end(), std::make_pair(id, 0u));
+        if (it == sols.end() || it->first != id) j.orphan_samples.push_back(std::move(path));
+    }
+}
+
+layout_t workspace::layout(const fs::path& root) {
+    layout_t out;
+    std::vector<layout_job_t> jobs;
+
+    // Tier folders are listed here for their level folders, which hold
+    // nearly every file and go to the pool.
+    for (const char* folder : { "Bronze", "Silver", "Gold", "Platinum", "Diamond", "Ruby" }) {
+        std::error_code ec;
+        if (!fs::is_directory(root / folder, ec)) continue;
+
+        jobs.push_back({ folder, tier_t(), true, { }, { }, { }, { } });
+
+        for (auto it = fs::directory_iterator(root / folder, ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+            std::string s = it->path().filename().string();
+            std::error_code e2;
+
+            if (s[0] == '.' || !it->is_directory(e2)) continue;
+
+            std::string rel = std::string(folder) + "/" + s;
+            tier_t t(s);
+
+            // "Gold/Silver 3" counts as Silver 3 in a scan, but patch and
+            // new look for Silver 3 in "Silver/Silver 3".
+            if (!t.valid() || t.path() != rel) {
+                out.unknown_dirs.push_back(rel);
+                t = tier_t();
+            }
+
+            jobs.push_back({ rel, t, false, { }, { }, { }, { } });
+        }
+    }
+
+    std::atomic<std::size_t> next { 0 };
+
+    auto work = [&] {
+        for (std::size_t i; (i = next++) < jobs.size(); )
+            list_layout(root, jobs[i].rel, jobs[i].level, jobs[i]);
+    };
+
+    std::size_t n = std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()), jobs.size());
+    std::vector<std::thread> pool;
+
+    for (std::size_t t = 1; t < n; t++) pool.emplace_back(work);
+    work();
+    for (auto& t : pool) t.join();
+
+    for (auto& j : jobs) {
+        out.solutions.insert(out.solutions.end(), j.solutions.begin(), j.solutions.end());
+        out.bad_names.insert(out.bad_names.end(), j.bad_names.begin(), j.bad_names.end());
+        out.unknown_dirs.insert(out.unknown_dirs.end(), j.unknown_dirs.begin(), j.unknown_dirs.end());
+        out.orphan_samples.insert(out.orphan_samples.end(), j.orphan_samples.begin(), j.orphan_samples.end());
+    }
+
+    std::sort(out.solutions.begin(), out.solutions.end(), [] (const layout_t::entry_t& a, const layout_t::entry_t& b) {
+        return a.id != b.id ? a.id < b.id : a.dir < b.dir;
+    });
+
+    std::sort(out.bad_names.begin(), out.bad_names.end());
+    std::sort(out.unknown_dirs.begin(), out.unknown_dirs.end());
+    std::sort(out.orphan_samples.begin(), out.orphan_samples.end());
+
+    return out;
+}